@@ -1,9 +1,12 @@
 #include <fstream>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "FisherKolmogorov1D.hpp"
 
+#include <deal.II/base/multithread_info.h>
+
 // Main function.
 int main(int argc, char *argv[]) {
   // Default values:
@@ -16,13 +19,30 @@ int main(int argc, char *argv[]) {
   if (argc > 2)
     alpha = std::stod(argv[2]);
 
+  // Threads used by the cell assembly (default: all the cores).
+  if (argc > 3)
+    MultithreadInfo::set_thread_limit(std::stoi(argv[3]));
+  std::cout << "Threads = " << MultithreadInfo::n_threads() << std::endl;
+
+  // Time scheme: theta method (1 = backward Euler, 0.5 = Crank-Nicolson) or
+  // BDF2.
+  double theta = 1.0;
+  std::string time_scheme = "Theta";
+  if (argc > 4)
+    theta = std::stod(argv[4]);
+  if (argc > 5)
+    time_scheme = argv[5];
+  AssertThrow(time_scheme == "Theta" || time_scheme == "BDF2",
+              ExcMessage("The time scheme must be Theta or BDF2."));
+  std::cout << "Time scheme = " << time_scheme << std::endl;
+
   const unsigned int N = 199;
   const unsigned int degree = 1;
   const double T = 20.0;
-  const double theta = 1;
   const double deltat = 0.1;
 
-  FisherKolmogorov1D problem(N, degree, T, deltat, theta, d, alpha);
+  FisherKolmogorov1D problem(N, degree, T, deltat, theta, d, alpha,
+                             time_scheme);
 
   problem.setup();
   problem.solve();
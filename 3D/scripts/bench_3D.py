@@ -0,0 +1,233 @@
+#!/usr/bin/env python
+
+# Scaling benchmark of main_3D, run by the bench_3D target.
+#
+# Each problem (the cube meshes of 3D_convergence, scaled so that they
+# contain the seed of the initial condition, and the meshes given on the
+# command line) is solved with each number of MPI processes, several times.
+# Every run appends a row to a CSV file through the "Benchmark file"
+# parameter of main_3D; the rows are collected into
+#   bench_3D_runs.csv     all the runs,
+#   bench_3D_summary.csv  the median of the repetitions of each case, with
+#                         the speedup and parallel efficiency,
+#   bench_3D.json         both of the above.
+#
+# Strong scaling runs every mesh with every number of processes. Weak
+# scaling pairs the i-th mesh with the i-th number of processes, so the
+# meshes should grow with the processes (each cube refinement has 8 times
+# the cells of the previous one). Every case is run with each of the linear
+# solvers, to compare CG with pipelined CG.
+
+import argparse
+import csv
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+
+phases = ["setup", "assemble", "preconditioner_setup", "cg", "output", "solve"]
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description = "Benchmark main_3D.")
+    parser.add_argument("--executable", required = True)
+    parser.add_argument("--parameters", required = True,
+                        help = "base parameter file of the runs")
+    parser.add_argument("--meshes", nargs = "*", default = [],
+                        help = "additional mesh files (e.g. the brain)")
+    parser.add_argument("--cube-geo", default = None,
+                        help = "cube.geo of 3D_convergence")
+    parser.add_argument("--cube-sizes", nargs = "*", type = int, default = [],
+                        help = "cube refinements generated with gmsh")
+    parser.add_argument("--cube-scale", type = float, default = 100.0,
+                        help = "side of the cubes")
+    parser.add_argument("--gmsh", default = "gmsh")
+    parser.add_argument("--ranks", nargs = "+", type = int, default = [1])
+    parser.add_argument("--repeats", type = int, default = 3)
+    parser.add_argument("--mode", choices = ["strong", "weak"],
+                        default = "strong")
+    parser.add_argument("--final-time", type = float, default = None,
+                        help = "final time of the runs (default: the one of "
+                               "the parameter file)")
+    parser.add_argument("--linear-solvers", nargs = "+", default = ["CG"],
+                        choices = ["CG", "PipeCG"],
+                        help = "\"Linear solver\" of the runs")
+    parser.add_argument("--mpiexec", default = "mpiexec")
+    parser.add_argument("--mpiexec-flags", default = "")
+    parser.add_argument("--output-dir", default = "bench_3D")
+    return parser.parse_args()
+
+
+def generate_cubes(args, mesh_dir):
+    meshes = []
+    if not args.cube_sizes:
+        return meshes
+
+    if args.cube_geo is None or shutil.which(args.gmsh) is None:
+        print("gmsh or cube.geo not found: skipping the cube meshes")
+        return meshes
+
+    os.makedirs(mesh_dir, exist_ok = True)
+    for h in args.cube_sizes:
+        mesh = os.path.join(mesh_dir, "mesh-cube-%d.msh" % h)
+        if not os.path.exists(mesh):
+            geo = os.path.join(mesh_dir, "mesh-cube-%d.geo" % h)
+            with open(geo, "w") as file:
+                file.write("h = %d;\n" % h)
+                file.write("Include \"%s\";\n" % os.path.abspath(args.cube_geo))
+                file.write("Mesh.ScalingFactor = %g;\n" % args.cube_scale)
+            subprocess.run([args.gmsh, "-3", geo, "-o", mesh], check = True,
+                           stdout = subprocess.DEVNULL)
+        meshes.append(mesh)
+
+    return meshes
+
+
+def run_case(args, mesh, ranks, solver, repeat, run_dir, record):
+    os.makedirs(run_dir, exist_ok = True)
+
+    # Later entries of a parameter file override the earlier ones.
+    parameters = os.path.join(run_dir, "parameters.prm")
+    with open(args.parameters) as base, open(parameters, "w") as file:
+        file.write(base.read())
+        file.write("\nsubsection Mesh & geometry parameters\n")
+        file.write("  set Mesh file = %s\n" % os.path.abspath(mesh))
+        file.write("end\n")
+        if args.final_time is not None:
+            file.write("subsection Time stepping parameters\n")
+            file.write("  set T = %g\n" % args.final_time)
+            file.write("end\n")
+        file.write("subsection Solver parameters\n")
+        file.write("  set Linear solver = %s\n" % solver)
+        file.write("end\n")
+        file.write("subsection Output parameters\n")
+        file.write("  set Benchmark file = %s\n" % os.path.abspath(record))
+        file.write("end\n")
+
+    command = [args.mpiexec, "-n", str(ranks)] + args.mpiexec_flags.split() + \
+              [os.path.abspath(args.executable), "parameters.prm"]
+
+    print("%s, %d processes, %s, run %d" % (os.path.basename(mesh), ranks,
+                                            solver, repeat + 1), flush = True)
+    with open(os.path.join(run_dir, "run.log"), "w") as log:
+        result = subprocess.run(command, cwd = run_dir, stdout = log,
+                                stderr = subprocess.STDOUT)
+
+    if result.returncode != 0:
+        print("  failed, see %s" % os.path.join(run_dir, "run.log"))
+        return None
+
+    with open(record) as file:
+        rows = list(csv.DictReader(file))
+    row = rows[-1]
+    row["repeat"] = repeat
+    return row
+
+
+def summarize(args, runs):
+    cases = {}
+    for run in runs:
+        cases.setdefault((run["mesh"], int(run["ranks"]), run["linear_solver"]),
+                         []).append(run)
+
+    summary = []
+    for (mesh, ranks, solver), case in cases.items():
+        entry = {"mesh": mesh, "ranks": ranks, "linear_solver": solver,
+                 "runs": len(case),
+                 "n_dofs": int(case[0]["n_dofs"]),
+                 "dofs_per_rank": int(case[0]["n_dofs"]) / ranks,
+                 "time_steps": int(case[0]["time_steps"])}
+        for key in phases + ["dofs_per_second", "cg_iterations_per_step"]:
+            entry[key] = statistics.median(float(run[key]) for run in case)
+        entry["solve_min"] = min(float(run["solve"]) for run in case)
+        summary.append(entry)
+
+    # Speedup and efficiency relative to the smallest number of processes of
+    # the same mesh (strong) or to the first case (weak), with the same
+    # linear solver.
+    for entry in summary:
+        if args.mode == "strong":
+            reference = min((other for other in summary
+                             if other["mesh"] == entry["mesh"] and
+                             other["linear_solver"] == entry["linear_solver"]),
+                            key = lambda other: other["ranks"])
+            speedup = reference["solve"] / entry["solve"]
+            entry["speedup"] = speedup
+            entry["efficiency"] = speedup * reference["ranks"] / entry["ranks"]
+        else:
+            reference = next(other for other in summary
+                             if other["linear_solver"] ==
+                             entry["linear_solver"])
+            entry["speedup"] = None
+            entry["efficiency"] = reference["solve"] / entry["solve"]
+
+    return summary
+
+
+def write_csv(file_name, rows):
+    if not rows:
+        return
+    with open(file_name, "w", newline = "") as file:
+        writer = csv.DictWriter(file, fieldnames = list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def main():
+    args = parse_arguments()
+    os.makedirs(args.output_dir, exist_ok = True)
+
+    meshes = generate_cubes(args, os.path.join(args.output_dir, "mesh"))
+    meshes += [mesh for mesh in args.meshes if os.path.exists(mesh)]
+    for mesh in args.meshes:
+        if not os.path.exists(mesh):
+            print("Mesh %s not found: skipping it" % mesh)
+
+    if not meshes:
+        sys.exit("No meshes to benchmark.")
+
+    if args.mode == "strong":
+        cases = [(mesh, ranks) for mesh in meshes for ranks in args.ranks]
+    else:
+        cases = list(zip(meshes, args.ranks))
+
+    cases = [(mesh, ranks, solver) for mesh, ranks in cases
+             for solver in args.linear_solvers]
+
+    runs = []
+    for mesh, ranks, solver in cases:
+        name = "%s-np%d-%s" % (os.path.splitext(os.path.basename(mesh))[0],
+                               ranks, solver)
+        for repeat in range(args.repeats):
+            run_dir = os.path.join(args.output_dir, name, "run%d" % repeat)
+            record = os.path.join(run_dir, "benchmark.csv")
+            if os.path.exists(record):
+                os.remove(record)
+
+            row = run_case(args, mesh, ranks, solver, repeat, run_dir, record)
+            if row is not None:
+                runs.append(row)
+
+    summary = summarize(args, runs)
+
+    write_csv(os.path.join(args.output_dir, "bench_3D_runs.csv"), runs)
+    write_csv(os.path.join(args.output_dir, "bench_3D_summary.csv"), summary)
+    with open(os.path.join(args.output_dir, "bench_3D.json"), "w") as file:
+        json.dump({"mode": args.mode, "repeats": args.repeats, "runs": runs,
+                   "summary": summary}, file, indent = 2)
+
+    print()
+    print("%-28s %6s %7s %12s %10s %10s %12s %8s" %
+          ("mesh", "ranks", "solver", "DoFs", "solve [s]", "efficiency",
+           "DoFs/s", "CG/step"))
+    for entry in summary:
+        print("%-28s %6d %7s %12d %10.3f %10.2f %12.4g %8.1f" %
+              (os.path.basename(entry["mesh"]), entry["ranks"],
+               entry["linear_solver"], entry["n_dofs"], entry["solve"], entry["efficiency"],
+               entry["dofs_per_second"], entry["cg_iterations_per_step"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,245 @@
+#!/usr/bin/env python
+
+# Restart test of main_3D, run by ctest.
+#
+# A BDF2 run is stopped at half of the final time, with a checkpoint, and
+# restarted from it up to the final time on a different number of processes,
+# so that the cells are redistributed by their id. Its last checkpoint must
+# match the one of an uninterrupted run: the restart has to resume with the
+# history of BDF2, and not with a backward Euler step. The partitions differ,
+# and so do the roundoff errors of the linear solves, hence the tolerance.
+#
+# The runs use a small cube mesh, generated here, whose side contains the
+# seed of the initial condition.
+#
+# With --adaptive the runs use adaptive time stepping. The uninterrupted run
+# goes first, and the first half of the restarted run stops at the time it
+# reached at half of its steps, so that both take the same steps.
+
+import argparse
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description = "Restart test of main_3D.")
+    parser.add_argument("--executable", required = True)
+    parser.add_argument("--parameters", required = True,
+                        help = "base parameter file of the runs")
+    parser.add_argument("--ranks", type = int, default = 1,
+                        help = "processes of the first half and of the "
+                        "uninterrupted run")
+    parser.add_argument("--restart-ranks", type = int, default = 2,
+                        help = "processes of the restarted second half")
+    parser.add_argument("--mpiexec", default = "mpiexec")
+    parser.add_argument("--mpiexec-flags", default = "")
+    parser.add_argument("--subdivisions", type = int, default = 5)
+    parser.add_argument("--side", type = float, default = 100.0)
+    parser.add_argument("--deltat", type = float, default = 1.0)
+    parser.add_argument("--steps", type = int, default = 8,
+                        help = "time steps of the uninterrupted run (even)")
+    parser.add_argument("--tolerance", type = float, default = 1e-6,
+                        help = "relative to the largest value")
+    parser.add_argument("--adaptive", action = "store_true",
+                        help = "use adaptive time stepping")
+    parser.add_argument("--output-dir", default = "test_restart")
+    return parser.parse_args()
+
+
+def write_cube_mesh(file_name, n, side):
+    # Gmsh 2.2 mesh of the cube [0, side]^3, with each of the n^3 hexahedra
+    # split into 6 tetrahedra along its main diagonal.
+    h = side / n
+    index = lambda i, j, k: 1 + i + (n + 1) * (j + (n + 1) * k)
+    points = [(i * h, j * h, k * h) for k in range(n + 1)
+              for j in range(n + 1) for i in range(n + 1)]
+
+    paths = [(0, 1, 2), (0, 2, 1), (1, 0, 2), (1, 2, 0), (2, 0, 1), (2, 1, 0)]
+    tetrahedra = []
+    for k in range(n):
+        for j in range(n):
+            for i in range(n):
+                for path in paths:
+                    corner = [i, j, k]
+                    vertices = [index(*corner)]
+                    for direction in path:
+                        corner[direction] += 1
+                        vertices.append(index(*corner))
+                    # Positive orientation of the vertices.
+                    p = [points[v - 1] for v in vertices]
+                    e = [[p[m][d] - p[0][d] for d in range(3)]
+                         for m in range(1, 4)]
+                    volume = (e[0][0] * (e[1][1] * e[2][2] - e[1][2] * e[2][1])
+                              - e[0][1] * (e[1][0] * e[2][2] -
+                                           e[1][2] * e[2][0])
+                              + e[0][2] * (e[1][0] * e[2][1] -
+                                           e[1][1] * e[2][0]))
+                    if volume < 0.0:
+                        vertices[2], vertices[3] = vertices[3], vertices[2]
+                    tetrahedra.append(vertices)
+
+    with open(file_name, "w") as file:
+        file.write("$MeshFormat\n2.2 0 8\n$EndMeshFormat\n")
+        file.write("$Nodes\n%d\n" % len(points))
+        for number, point in enumerate(points, 1):
+            file.write("%d %.17g %.17g %.17g\n" % ((number,) + point))
+        file.write("$EndNodes\n")
+        file.write("$Elements\n%d\n" % len(tetrahedra))
+        for number, vertices in enumerate(tetrahedra, 1):
+            file.write("%d 4 2 1 1 %d %d %d %d\n" % ((number,) +
+                                                     tuple(vertices)))
+        file.write("$EndElements\n")
+
+
+def run(args, run_dir, mesh, final_time, restart, ranks):
+    # Later entries of a parameter file override the earlier ones.
+    parameters = os.path.join(run_dir, "parameters.prm")
+    with open(args.parameters) as base, open(parameters, "w") as file:
+        file.write(base.read())
+        file.write("\nsubsection Mesh & geometry parameters\n")
+        file.write("  set Mesh file = %s\n" % os.path.abspath(mesh))
+        file.write("  set Adaptive refinement = false\n")
+        file.write("end\n")
+        file.write("subsection Time stepping parameters\n")
+        file.write("  set T = %.17g\n" % final_time)
+        file.write("  set deltat = %.17g\n" % args.deltat)
+        file.write("  set Time integrator = Newton\n")
+        file.write("  set Time scheme = BDF2\n")
+        if args.adaptive:
+            # Steps of deltat times a power of 2, exactly printed in the log.
+            file.write("  set Adaptive time stepping = true\n")
+            file.write("  set Min deltat = %.17g\n" % (0.25 * args.deltat))
+            file.write("  set Max deltat = %.17g\n" % (2.0 * args.deltat))
+            file.write("  set Growth factor = 2\n")
+        else:
+            file.write("  set Adaptive time stepping = false\n")
+        file.write("end\n")
+        file.write("subsection Output parameters\n")
+        file.write("  set Output interval = %d\n" % (2 * args.steps))
+        file.write("  set Write partitioning = false\n")
+        file.write("end\n")
+        file.write("subsection Checkpoint parameters\n")
+        # The adaptive runs do not know in advance at which step they stop,
+        # so they checkpoint every step; only the last one is kept.
+        file.write("  set Checkpoint interval = %d\n" %
+                   (1 if args.adaptive else args.steps // 2))
+        file.write("  set Checkpoint directory = checkpoint\n")
+        file.write("  set Restart = %s\n" % ("true" if restart else "false"))
+        file.write("end\n")
+
+    command = [args.mpiexec, "-n", str(ranks)] + \
+              args.mpiexec_flags.split() + \
+              [os.path.abspath(args.executable), "parameters.prm"]
+
+    log_name = os.path.join(run_dir, "restart.log" if restart else "run.log")
+    with open(log_name, "w") as log:
+        result = subprocess.run(command, cwd = run_dir, stdout = log,
+                                stderr = subprocess.STDOUT)
+    if result.returncode != 0:
+        sys.exit("main_3D failed, see %s" % log_name)
+    return log_name
+
+
+def read_step_times(log_name):
+    # The time reached at each time step, from the log of a run. A rejected
+    # step is printed again when it is repeated.
+    times = {}
+    with open(log_name) as log:
+        for line in log:
+            match = re.match(r"n =\s*(\d+), t =\s*(\S+)", line)
+            if match:
+                times[int(match.group(1))] = float(match.group(2))
+    return times
+
+
+def read_checkpoint(directory):
+    # The values of u, u_old and u_older on every cell, by cell id.
+    with open(os.path.join(directory, "checkpoint.info")) as file:
+        info = file.read().split()
+    time_step = int(info[0])
+    n_pieces = int(info[3])
+    dofs_per_cell = int(info[4])
+    generation = os.path.join(directory, info[7])
+
+    cells = {}
+    for rank in range(n_pieces):
+        piece = os.path.join(generation, "solution.%04d.bin" % rank)
+        with open(piece, "rb") as file:
+            data = file.read()
+        _, _, n_cells = struct.unpack_from("<IIQ", data)
+        if n_cells == 0:
+            continue
+        record = (len(data) - 16) // n_cells
+        id_size = record - 24 * dofs_per_cell
+        for c in range(n_cells):
+            offset = 16 + c * record
+            cell_id = data[offset:offset + id_size]
+            values = struct.unpack_from("<%dd" % (3 * dofs_per_cell), data,
+                                        offset + id_size)
+            cells[cell_id] = values
+
+    return time_step, cells
+
+
+def main():
+    args = parse_arguments()
+    if args.steps % 2 != 0:
+        sys.exit("The number of time steps must be even.")
+
+    shutil.rmtree(args.output_dir, ignore_errors = True)
+    restart_dir = os.path.join(args.output_dir, "restart")
+    reference_dir = os.path.join(args.output_dir, "reference")
+    os.makedirs(restart_dir)
+    os.makedirs(reference_dir)
+
+    mesh = os.path.join(args.output_dir, "cube.msh")
+    write_cube_mesh(mesh, args.subdivisions, args.side)
+
+    final_time = args.steps * args.deltat
+    if args.adaptive:
+        times = read_step_times(run(args, reference_dir, mesh, final_time,
+                                    False, args.ranks))
+        n_steps = max(times)
+        if n_steps < 2:
+            sys.exit("The uninterrupted run took less than two time steps.")
+        run(args, restart_dir, mesh, times[n_steps // 2], False, args.ranks)
+        run(args, restart_dir, mesh, final_time, True, args.restart_ranks)
+    else:
+        n_steps = args.steps
+        run(args, restart_dir, mesh, 0.5 * final_time, False, args.ranks)
+        run(args, restart_dir, mesh, final_time, True, args.restart_ranks)
+        run(args, reference_dir, mesh, final_time, False, args.ranks)
+
+    step, restarted = read_checkpoint(os.path.join(restart_dir, "checkpoint"))
+    reference_step, reference = read_checkpoint(
+        os.path.join(reference_dir, "checkpoint"))
+
+    if step != n_steps or reference_step != n_steps:
+        sys.exit("The last checkpoints are at steps %d and %d, not %d." %
+                 (step, reference_step, n_steps))
+    # Committing a generation removes the older ones.
+    generations = [name for name in os.listdir(os.path.join(restart_dir,
+                                                            "checkpoint"))
+                   if name.startswith("step-")]
+    if len(generations) != 1:
+        sys.exit("Expected one checkpoint generation, found %s." %
+                 generations)
+    if restarted.keys() != reference.keys():
+        sys.exit("The checkpoints have different cells.")
+
+    scale = max(max(abs(v) for v in values) for values in reference.values())
+    error = max(abs(a - b) for cell in reference
+                for a, b in zip(restarted[cell], reference[cell]))
+    print("Maximum difference from the uninterrupted run: %g (scale %g)" %
+          (error, scale))
+
+    if error > args.tolerance * max(scale, 1.0):
+        sys.exit("The restarted run differs from the uninterrupted one.")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,6 +1,8 @@
 #ifndef DIFFUSION_TENSOR_HPP
 #define DIFFUSION_TENSOR_HPP
 
+#include "FiberField.hpp"
+
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/tensor_function.h>
@@ -27,6 +29,8 @@
 #include <deal.II/numerics/matrix_tools.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <memory>
+
 using namespace dealii;
 
 template <unsigned int DIM>
@@ -129,4 +133,32 @@ private:
   const Point<2> cir_center;
 };
 
+
+// Fibers read from a voxel field (see FiberField), e.g. from DTI data. The
+// field is shared by the copies of the tensor.
+template <unsigned int DIM>
+class FiberFieldDiffusionTensor : public DiffusionTensor<DIM>
+{
+public:
+  FiberFieldDiffusionTensor(const double dext, const double daxn,
+                            const std::string &file_name)
+    : DiffusionTensor<DIM>(dext, daxn),
+      field(std::make_shared<const FiberField>(file_name)) {}
+
+  FiberFieldDiffusionTensor(const double dext, const double daxn,
+                            const std::shared_ptr<const FiberField> &field)
+    : DiffusionTensor<DIM>(dext, daxn), field(field) {}
+
+protected:
+  Tensor<1, DIM> compute_fiber(const Point<DIM> &p) const override
+  {
+    static_assert(DIM == 3, "FiberFieldDiffusionTensor requires DIM == 3");
+
+    return field->direction(p);
+  }
+
+private:
+  const std::shared_ptr<const FiberField> field;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,307 @@
+#ifndef FIBER_FIELD_HPP
+#define FIBER_FIELD_HPP
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/point.h>
+#include <deal.II/base/tensor.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// Fiber directions sampled at the centers of the voxels of a regular grid,
+// e.g. the principal eigenvectors of a DTI scan, read from
+//  - a NIfTI-1 file (.nii), with a 4D (x, y, z, 3) or 5D (x, y, z, 1, 3)
+//    float32 or float64 image. The voxel-to-world map is the sform, or the
+//    qform, or the voxel spacing if neither is set. The components are
+//    stored in single precision, like those of the raw format, so float64
+//    images are rounded to float;
+//  - any other file, as the raw binary format
+//      char[8]      "FKFIBERS"
+//      uint32[3]    number of voxels along x, y and z
+//      uint32       0 (padding)
+//      float64[3]   world coordinates of the center of the first voxel
+//      float64[3]   voxel spacing along x, y and z
+//      float32[]    the 3 components of each voxel, x varying fastest,
+//    in the byte order of the machine. The file is memory-mapped: loading
+//    it costs nothing, and the processes of a node share its pages.
+// The world coordinates are those of the mesh.
+class FiberField {
+public:
+  explicit FiberField(const std::string &file_name) {
+    const bool nifti = file_name.size() >= 4 &&
+                       file_name.compare(file_name.size() - 4, 4, ".nii") == 0;
+    if (nifti)
+      read_nifti(file_name);
+    else
+      map_raw(file_name);
+  }
+
+  FiberField(const FiberField &) = delete;
+  FiberField &operator=(const FiberField &) = delete;
+
+  // Fiber at the point p, trilinearly interpolated between the centers of
+  // the 8 closest voxels, and clamped to the voxels at the borders of the
+  // grid. A fiber and its opposite are the same direction, so the voxels
+  // are first oriented like the nearest one. The direction is that of the
+  // weighted sum and the length the weighted mean of the lengths, so that
+  // unit fibers stay unit vectors and fibers scaled by the anisotropy are
+  // interpolated as such.
+  Tensor<1, 3> direction(const Point<3> &p) const {
+    const Tensor<1, 3> x = to_voxel * (p - first_voxel);
+
+    std::array<unsigned int, 3> i0, i1;
+    std::array<double, 3> t;
+    for (unsigned int c = 0; c < 3; ++c) {
+      const double xc = std::min(std::max(x[c], 0.0), double(n[c] - 1));
+      i0[c] = std::min(static_cast<unsigned int>(xc), n[c] - 1);
+      i1[c] = std::min(i0[c] + 1, n[c] - 1);
+      t[c] = xc - i0[c];
+    }
+
+    // Nearest voxel, which sets the orientation.
+    const float *nearest =
+        voxel(t[0] < 0.5 ? i0[0] : i1[0], t[1] < 0.5 ? i0[1] : i1[1],
+              t[2] < 0.5 ? i0[2] : i1[2]);
+
+    Tensor<1, 3> sum;
+    double length = 0.0;
+    for (unsigned int corner = 0; corner < 8; ++corner) {
+      const bool ux = corner & 1, uy = corner & 2, uz = corner & 4;
+      const double w = (ux ? t[0] : 1 - t[0]) * (uy ? t[1] : 1 - t[1]) *
+                       (uz ? t[2] : 1 - t[2]);
+      if (w == 0.0)
+        continue;
+
+      const float *v = voxel(ux ? i1[0] : i0[0], uy ? i1[1] : i0[1],
+                             uz ? i1[2] : i0[2]);
+      const double dot =
+          v[0] * nearest[0] + v[1] * nearest[1] + v[2] * nearest[2];
+      const double ws = dot < 0.0 ? -w : w;
+
+      for (unsigned int c = 0; c < 3; ++c)
+        sum[c] += ws * v[c];
+      length += w * std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+
+    const double norm = sum.norm();
+    if (norm < 1e-12)
+      return Tensor<1, 3>();
+
+    return (length / norm) * sum;
+  }
+
+  // Number of voxels of the grid.
+  std::size_t n_voxels() const { return std::size_t(n[0]) * n[1] * n[2]; }
+
+private:
+  // Components of a voxel.
+  const float *voxel(const unsigned int i, const unsigned int j,
+                     const unsigned int k) const {
+    return data + 3 * (i + std::size_t(n[0]) * (j + std::size_t(n[1]) * k));
+  }
+
+  void read_nifti(const std::string &file_name) {
+    std::ifstream file(file_name, std::ios::binary);
+    AssertThrow(file.is_open(),
+                ExcMessage("Could not open the fiber field " + file_name));
+
+    char header[348];
+    file.read(header, sizeof(header));
+    AssertThrow(file, ExcMessage("Could not read the NIfTI header of " +
+                                 file_name));
+
+    const auto field = [&header](auto value, const unsigned int offset) {
+      std::memcpy(&value, header + offset, sizeof(value));
+      return value;
+    };
+
+    AssertThrow(field(std::int32_t(), 0) == 348,
+                ExcMessage(file_name + " is not a NIfTI-1 file in the byte "
+                                       "order of this machine"));
+
+    std::array<std::int16_t, 8> dims;
+    std::array<float, 8> pixdim;
+    for (unsigned int d = 0; d < 8; ++d) {
+      dims[d] = field(std::int16_t(), 40 + 2 * d);
+      pixdim[d] = field(float(), 76 + 4 * d);
+    }
+
+    // The components are the 4th dimension, or the 5th one (vector intent).
+    const bool vector_4d = dims[0] == 4 && dims[4] == 3;
+    const bool vector_5d = dims[0] == 5 && dims[4] == 1 && dims[5] == 3;
+    AssertThrow(vector_4d || vector_5d,
+                ExcMessage("The NIfTI image " + file_name +
+                           " is not a field of 3D vectors"));
+
+    for (unsigned int c = 0; c < 3; ++c) {
+      AssertThrow(dims[c + 1] > 0,
+                  ExcMessage("Empty NIfTI image " + file_name));
+      n[c] = dims[c + 1];
+    }
+
+    // Voxel-to-world map.
+    Tensor<2, 3> to_world;
+    Tensor<1, 3> offset;
+    if (field(std::int16_t(), 254) > 0) {
+      for (unsigned int r = 0; r < 3; ++r) {
+        for (unsigned int c = 0; c < 3; ++c)
+          to_world[r][c] = field(float(), 280 + 16 * r + 4 * c);
+        offset[r] = field(float(), 280 + 16 * r + 12);
+      }
+    } else if (field(std::int16_t(), 252) > 0) {
+      const double b = field(float(), 256);
+      const double c = field(float(), 260);
+      const double d = field(float(), 264);
+      const double a = std::sqrt(std::max(1.0 - b * b - c * c - d * d, 0.0));
+      const double qfac = pixdim[0] < 0 ? -1.0 : 1.0;
+
+      const double rotation[3][3] = {
+          {a * a + b * b - c * c - d * d, 2 * (b * c - a * d),
+           2 * (b * d + a * c)},
+          {2 * (b * c + a * d), a * a + c * c - b * b - d * d,
+           2 * (c * d - a * b)},
+          {2 * (b * d - a * c), 2 * (c * d + a * b),
+           a * a + d * d - c * c - b * b}};
+      const double scale[3] = {pixdim[1], pixdim[2], qfac * pixdim[3]};
+
+      for (unsigned int r = 0; r < 3; ++r) {
+        for (unsigned int s = 0; s < 3; ++s)
+          to_world[r][s] = rotation[r][s] * scale[s];
+        offset[r] = field(float(), 268 + 4 * r);
+      }
+    } else {
+      for (unsigned int c = 0; c < 3; ++c)
+        to_world[c][c] = pixdim[c + 1];
+    }
+
+    AssertThrow(std::abs(determinant(to_world)) > 0.0,
+                ExcMessage("Singular voxel-to-world map in " + file_name));
+    to_voxel = invert(to_world);
+    first_voxel = Point<3>(offset);
+
+    // Component-major data, stored again voxel by voxel, so that the three
+    // components of a voxel are next to each other.
+    const std::int16_t datatype = field(std::int16_t(), 70);
+    AssertThrow(datatype == 16 || datatype == 64,
+                ExcMessage("The NIfTI image " + file_name +
+                           " is neither float32 nor float64"));
+
+    const std::size_t n_values = 3 * n_voxels();
+    std::vector<double> values(n_values);
+
+    file.seekg(static_cast<std::streamoff>(field(float(), 108)));
+    if (datatype == 16) {
+      std::vector<float> buffer(n_values);
+      file.read(reinterpret_cast<char *>(buffer.data()),
+                n_values * sizeof(float));
+      std::copy(buffer.begin(), buffer.end(), values.begin());
+    } else
+      file.read(reinterpret_cast<char *>(values.data()),
+                n_values * sizeof(double));
+    AssertThrow(file, ExcMessage("Could not read the NIfTI image " +
+                                 file_name));
+
+    storage.resize(n_values);
+    const std::size_t n_v = n_voxels();
+    for (std::size_t v = 0; v < n_v; ++v)
+      for (unsigned int c = 0; c < 3; ++c)
+        storage[3 * v + c] = values[c * n_v + v];
+
+    data = storage.data();
+  }
+
+  void map_raw(const std::string &file_name) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    AssertThrow(fd >= 0,
+                ExcMessage("Could not open the fiber field " + file_name));
+
+    struct stat status;
+    const bool stat_ok = fstat(fd, &status) == 0;
+    const std::size_t size = stat_ok ? status.st_size : 0;
+
+    void *address =
+        size >= header_size
+            ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+    close(fd);
+
+    AssertThrow(address != MAP_FAILED,
+                ExcMessage("Could not map the fiber field " + file_name));
+
+    // Owned by the member from here on, so that it is unmapped if one of the
+    // checks below throws out of the constructor.
+    mapping.address = address;
+    mapping.size = size;
+
+    const char *bytes = static_cast<const char *>(address);
+    AssertThrow(std::memcmp(bytes, "FKFIBERS", 8) == 0,
+                ExcMessage(file_name + " is not a raw fiber field"));
+
+    std::array<std::uint32_t, 3> sizes;
+    std::array<double, 3> origin, spacing;
+    std::memcpy(sizes.data(), bytes + 8, sizeof(sizes));
+    std::memcpy(origin.data(), bytes + 24, sizeof(origin));
+    std::memcpy(spacing.data(), bytes + 48, sizeof(spacing));
+
+    for (unsigned int c = 0; c < 3; ++c) {
+      AssertThrow(sizes[c] > 0 && spacing[c] > 0.0,
+                  ExcMessage("Invalid grid in the fiber field " + file_name));
+      n[c] = sizes[c];
+      first_voxel[c] = origin[c];
+      to_voxel[c][c] = 1.0 / spacing[c];
+    }
+
+    AssertThrow(mapping.size == header_size + 3 * n_voxels() * sizeof(float),
+                ExcMessage("The size of the fiber field " + file_name +
+                           " does not match its grid"));
+
+    data = reinterpret_cast<const float *>(bytes + header_size);
+  }
+
+  // Size of the header of the raw format.
+  static constexpr std::size_t header_size = 72;
+
+  // Number of voxels along each axis.
+  std::array<unsigned int, 3> n = {{1, 1, 1}};
+
+  // Map from world coordinates, relative to the center of the first voxel,
+  // to voxel coordinates.
+  Tensor<2, 3> to_voxel;
+  Point<3> first_voxel;
+
+  // Components of the voxels, in the mapped file or in storage.
+  const float *data = nullptr;
+  std::vector<float> storage;
+
+  // Memory mapping of the raw format, unmapped on destruction.
+  struct Mapping {
+    Mapping() = default;
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+
+    ~Mapping() {
+      if (address != nullptr)
+        munmap(address, size);
+    }
+
+    void *address = nullptr;
+    std::size_t size = 0;
+  };
+
+  Mapping mapping;
+};
+
+#endif
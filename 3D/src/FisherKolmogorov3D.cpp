@@ -1,5 +1,123 @@
 #include "FisherKolmogorov3D.hpp"
 
+namespace {
+// Copy the locally owned entries of src into dst. Trilinos and matrix-free
+// vectors built on the same DoF handler share the same numbering.
+template <typename VectorTo, typename VectorFrom>
+void copy_locally_owned(VectorTo &dst, const VectorFrom &src,
+                        const IndexSet &locally_owned_dofs) {
+  for (const auto i : locally_owned_dofs)
+    dst(i) = src(i);
+}
+
+// Indices of the given points, sorted along a Hilbert space-filling curve.
+template <int dim>
+std::vector<unsigned int> hilbert_order(const std::vector<Point<dim>> &points) {
+  const int bits_per_dim = 64 / dim;
+  const auto coordinates =
+      Utilities::inverse_Hilbert_space_filling_curve(points, bits_per_dim);
+
+  std::vector<std::uint64_t> curve_index(points.size());
+  for (unsigned int i = 0; i < points.size(); ++i)
+    curve_index[i] = Utilities::pack_integers<dim>(coordinates[i], bits_per_dim);
+
+  std::vector<unsigned int> order(points.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&curve_index](const unsigned int a, const unsigned int b) {
+                     return curve_index[a] < curve_index[b];
+                   });
+
+  return order;
+}
+} // namespace
+
+void FisherKolmogorov3D::set_mesh_parameters(
+    const std::string &loading, const unsigned int group_size,
+    const bool cache, const std::string &cache_directory) {
+  mesh_loading = loading;
+  mesh_group_size = group_size;
+  mesh_cache = cache;
+  mesh_cache_directory = cache_directory;
+
+  pcout << "-----------------------------------------------" << std::endl;
+  pcout << "Setting mesh parameters" << std::endl;
+  pcout << "  Mesh loading               = " << mesh_loading << std::endl;
+  if (mesh_loading == "Groups")
+    pcout << "  Group size                 = "
+          << (mesh_group_size == 0 ? mpi_size : mesh_group_size)
+          << std::endl;
+  pcout << "  Mesh cache                 = " << (mesh_cache ? "true" : "false")
+        << std::endl;
+  if (mesh_cache)
+    pcout << "  Mesh cache directory       = " << mesh_cache_directory
+          << std::endl;
+}
+
+void FisherKolmogorov3D::set_element_type(const std::string &element_type_) {
+  element_type = element_type_;
+
+  pcout << "  Element type               = " << element_type << std::endl;
+}
+
+void FisherKolmogorov3D::set_refinement_parameters(
+    const bool adaptive, const unsigned int interval,
+    const std::string &indicator, const double refine_fraction_,
+    const double coarsen_fraction_, const unsigned int max_level,
+    const unsigned int initial_cycles) {
+  adaptive_refinement = adaptive;
+  refinement_interval = interval;
+  refinement_indicator = indicator;
+  refine_fraction = refine_fraction_;
+  coarsen_fraction = coarsen_fraction_;
+  max_refinement_level = max_level;
+  initial_refinement_cycles = initial_cycles;
+
+  pcout << "  Adaptive refinement        = "
+        << (adaptive_refinement ? "true" : "false") << std::endl;
+  if (adaptive_refinement) {
+    pcout << "  Refinement interval        = " << refinement_interval
+          << " time steps" << std::endl;
+    pcout << "  Refinement indicator       = " << refinement_indicator
+          << std::endl;
+    pcout << "  Refine fraction            = " << refine_fraction << std::endl;
+    pcout << "  Coarsen fraction           = " << coarsen_fraction
+          << std::endl;
+    pcout << "  Max refinement level       = " << max_refinement_level
+          << std::endl;
+    pcout << "  Initial refinement cycles  = " << initial_refinement_cycles
+          << std::endl;
+  }
+}
+
+void FisherKolmogorov3D::set_rebalancing_parameters(
+    const unsigned int interval, const std::string &cost,
+    const double threshold) {
+  rebalance_interval = interval;
+  rebalance_cost = cost;
+  rebalance_threshold = threshold;
+
+  pcout << "  Rebalance interval         = " << rebalance_interval
+        << " time steps" << std::endl;
+  if (rebalance_interval > 0) {
+    pcout << "  Rebalance cost             = " << rebalance_cost << std::endl;
+    pcout << "  Rebalance threshold        = " << rebalance_threshold
+          << std::endl;
+  }
+}
+
+void FisherKolmogorov3D::set_partitioning_parameters(
+    const std::string &partitioner_, const unsigned int seed_weight,
+    const std::string &renumbering) {
+  partitioner = partitioner_;
+  seed_cell_weight = seed_weight;
+  dof_renumbering = renumbering;
+
+  pcout << "  Partitioner                = " << partitioner << std::endl;
+  pcout << "  Seed cell weight           = " << seed_cell_weight << std::endl;
+  pcout << "  DoF renumbering            = " << dof_renumbering << std::endl;
+}
+
 void FisherKolmogorov3D::set_solver_parameters(
     const unsigned int max_newton_iter, const double newton_tol,
     const unsigned int max_cg_iter, const double cg_tol_factor) {
@@ -19,28 +137,372 @@ void FisherKolmogorov3D::set_solver_parameters(
   pcout << "-----------------------------------------------" << std::endl;
 }
 
+void FisherKolmogorov3D::set_linear_solver(
+    const std::string &linear_solver_) {
+  linear_solver = linear_solver_;
+
+  pcout << "Setting linear solver" << std::endl;
+  pcout << "  Krylov solver              = "
+        << (linear_solver == "PipeCG" ? "Pipelined CG" : "CG") << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_matrix_free(const bool matrix_free_,
+                                         const bool mixed_precision_) {
+  matrix_free = matrix_free_;
+  mixed_precision = mixed_precision_;
+
+  pcout << "Jacobian operator" << std::endl;
+  pcout << "  Type                       = "
+        << (matrix_free ? "Matrix-free" : "Matrix-based") << std::endl;
+  if (matrix_free)
+    pcout << "  Linear solver precision    = "
+          << (mixed_precision ? "Mixed" : "Double") << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_assembly_parameters(const bool split_assembly_,
+                                                 const bool lumped_reaction_) {
+  split_assembly = split_assembly_;
+  lumped_reaction = lumped_reaction_;
+
+  pcout << "Setting assembly parameters" << std::endl;
+  pcout << "  Jacobian assembly          = "
+        << (split_assembly ? "Split" : "Full") << std::endl;
+  pcout << "  Reaction mass              = "
+        << (lumped_reaction ? "Lumped" : "Consistent") << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_active_region_parameters(
+    const bool active_region, const double tolerance, const unsigned int halo,
+    const unsigned int active_weight) {
+  active_region_assembly = active_region;
+  active_region_tolerance = tolerance;
+  active_region_halo = halo;
+  active_cell_weight = active_weight;
+
+  pcout << "Setting active region parameters" << std::endl;
+  pcout << "  Active region assembly     = "
+        << (active_region_assembly ? "true" : "false") << std::endl;
+  if (active_region_assembly) {
+    pcout << "  Active region tolerance    = " << active_region_tolerance
+          << std::endl;
+    pcout << "  Active region halo         = " << active_region_halo
+          << std::endl;
+    pcout << "  Active cell weight         = " << active_cell_weight
+          << std::endl;
+  }
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_communication_overlap(const bool overlap) {
+  communication_overlap = overlap;
+
+  pcout << "Setting communication overlap" << std::endl;
+  pcout << "  Communication overlap      = "
+        << (communication_overlap ? "true" : "false") << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_preconditioner_parameters(
+    const std::string &type, const unsigned int rebuild_interval,
+    const std::string &amg_smoother, const unsigned int amg_sweeps,
+    const double amg_threshold) {
+  preconditioner_type = type;
+  preconditioner_rebuild_interval = rebuild_interval;
+  amg_smoother_type = amg_smoother;
+  amg_smoother_sweeps = amg_sweeps;
+  amg_aggregation_threshold = amg_threshold;
+
+  pcout << "Setting preconditioner parameters" << std::endl;
+  pcout << "  Preconditioner             = " << preconditioner_type
+        << std::endl;
+  pcout << "  Rebuild interval           = " << preconditioner_rebuild_interval
+        << (preconditioner_rebuild_interval == 0 ? " (every Newton iteration)"
+                                                 : " time steps")
+        << std::endl;
+  if (preconditioner_type == "AMG") {
+    pcout << "  AMG smoother type          = " << amg_smoother_type
+          << std::endl;
+    pcout << "  AMG smoother sweeps        = " << amg_smoother_sweeps
+          << std::endl;
+    pcout << "  AMG aggregation threshold  = " << amg_aggregation_threshold
+          << std::endl;
+  }
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_operator_cache(const double threshold) {
+  operator_cache_threshold = threshold;
+
+  pcout << "Setting operator cache" << std::endl;
+  pcout << "  Operator cache threshold   = " << operator_cache_threshold
+        << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_output_parameters(const std::string &format,
+                                               const unsigned int interval,
+                                               const double time_interval,
+                                               const bool write_partitioning_,
+                                               const bool asynchronous) {
+  output_format = format;
+  output_interval = interval;
+  output_time_interval = time_interval;
+  write_partitioning = write_partitioning_;
+  asynchronous_output = asynchronous;
+
+  pcout << "Setting output parameters" << std::endl;
+  pcout << "  Output format              = " << output_format << std::endl;
+  if (output_time_interval > 0.0)
+    pcout << "  Output time interval       = " << output_time_interval
+          << std::endl;
+  else
+    pcout << "  Output interval            = " << output_interval
+          << " time steps" << std::endl;
+  pcout << "  Write partitioning         = "
+        << (write_partitioning ? "true" : "false") << std::endl;
+  pcout << "  Asynchronous output        = "
+        << (asynchronous_output ? "true" : "false") << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_output_name(const std::string &name) {
+  output_name = name;
+
+  pcout << "  Output name                = " << output_name << std::endl;
+}
+
+void FisherKolmogorov3D::set_metrics_parameters(const std::string &file,
+                                                const std::string &format) {
+  metrics_file = file;
+  metrics_format = format;
+
+  pcout << "Setting metrics parameters" << std::endl;
+  if (metrics_file.empty())
+    pcout << "  Metrics file               = (none)" << std::endl;
+  else {
+    pcout << "  Metrics file               = " << metrics_file << std::endl;
+    pcout << "  Metrics format             = " << metrics_format << std::endl;
+  }
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_problem_coefficients(
+    const std::shared_ptr<DiffusionTensor<dim>> &d_, const double alpha_) {
+  set_problem_coefficients(*d_, alpha_);
+  d_owner = d_;
+}
+
+void FisherKolmogorov3D::set_problem_coefficients(DiffusionTensor<dim> &d_,
+                                                  const double alpha_) {
+  d = &d_;
+  alpha = alpha_;
+
+  pcout << "Setting problem coefficients" << std::endl;
+  pcout << "  alpha                      = " << alpha << std::endl;
+
+  // Before setup() there is nothing to update.
+  if (dof_handler.n_dofs() == 0)
+    return;
+
+  cache_diffusion_tensor();
+
+  if (active_region_assembly)
+    cache_cell_matrices();
+  if (matrix_free)
+    jacobian_operator.set_coefficients(*d, alpha, deltat);
+  if (mixed_precision)
+    jacobian_operator_float.set_coefficients(jacobian_operator);
+  if (!matrix_free && (split_assembly || lumped_reaction))
+    assemble_constant_matrix();
+  if (time_integrator != "Newton") {
+    assemble_linear_operators();
+    update_linear_system_matrix();
+  }
+
+  preconditioner_outdated = true;
+  linearization_valid = false;
+}
+
+void FisherKolmogorov3D::set_snapshot_interval(const unsigned int interval) {
+  snapshot_interval = interval;
+
+  pcout << "  Snapshot interval          = " << snapshot_interval << std::endl;
+}
+
+void FisherKolmogorov3D::set_checkpoint_parameters(
+    const unsigned int interval, const std::string &directory,
+    const bool restart_) {
+  checkpoint_interval = interval;
+  checkpoint_directory = directory;
+  restart = restart_;
+
+  pcout << "Setting checkpoint parameters" << std::endl;
+  pcout << "  Checkpoint interval        = " << checkpoint_interval
+        << (checkpoint_interval == 0 ? " (disabled)" : " time steps")
+        << std::endl;
+  pcout << "  Checkpoint directory       = " << checkpoint_directory
+        << std::endl;
+  pcout << "  Restart                    = " << (restart ? "true" : "false")
+        << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_adaptive_time_stepping(
+    const bool adaptive, const double min_deltat, const double max_deltat,
+    const unsigned int target_newton, const unsigned int target_cg,
+    const double growth_factor) {
+  adaptive_time_stepping = adaptive;
+  deltat_min = min_deltat;
+  deltat_max = max_deltat;
+  target_newton_iterations = target_newton;
+  target_cg_iterations = target_cg;
+  deltat_growth_factor = growth_factor;
+
+  pcout << "Setting time step controller" << std::endl;
+  pcout << "  Adaptive time stepping     = "
+        << (adaptive_time_stepping ? "true" : "false") << std::endl;
+  if (adaptive_time_stepping) {
+    pcout << "  Min deltat                 = " << deltat_min << std::endl;
+    pcout << "  Max deltat                 = " << deltat_max << std::endl;
+    pcout << "  Target Newton iterations   = " << target_newton_iterations
+          << std::endl;
+    pcout << "  Target CG iterations       = " << target_cg_iterations
+          << std::endl;
+    pcout << "  Growth factor              = " << deltat_growth_factor
+          << std::endl;
+  }
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_predictor(const std::string &predictor_type_) {
+  predictor_type = predictor_type_;
+
+  pcout << "Newton predictor" << std::endl;
+  pcout << "  Type                       = " << predictor_type << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_time_integrator(const std::string &integrator,
+                                             const double theta_,
+                                             const std::string &time_scheme_) {
+  time_integrator = integrator;
+  theta = theta_;
+  time_scheme = time_scheme_;
+
+  pcout << "Setting time integrator" << std::endl;
+  pcout << "  Time integrator            = " << time_integrator << std::endl;
+  if (time_integrator == "Newton")
+    pcout << "  Time scheme                = " << time_scheme << std::endl;
+  if (time_integrator != "Newton" || time_scheme == "Theta")
+    pcout << "  Theta                      = " << theta << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::set_newton_parameters(
+    const bool inexact, const double gamma, const double exponent,
+    const double max_forcing, const bool reuse, const double reuse_threshold) {
+  inexact_newton = inexact;
+  forcing_gamma = gamma;
+  forcing_exponent = exponent;
+  max_forcing_term = max_forcing;
+  jacobian_reuse = reuse;
+  jacobian_reuse_threshold = reuse_threshold;
+
+  pcout << "Setting Newton parameters" << std::endl;
+  pcout << "  Inexact Newton             = "
+        << (inexact_newton ? "true" : "false") << std::endl;
+  if (inexact_newton) {
+    pcout << "  Forcing term gamma         = " << forcing_gamma << std::endl;
+    pcout << "  Forcing term exponent      = " << forcing_exponent
+          << std::endl;
+    pcout << "  Max forcing term           = " << max_forcing_term
+          << std::endl;
+  }
+  pcout << "  Jacobian reuse             = "
+        << (jacobian_reuse ? "true" : "false") << std::endl;
+  if (jacobian_reuse)
+    pcout << "  Jacobian reuse threshold   = " << jacobian_reuse_threshold
+          << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+void FisherKolmogorov3D::check_solver_options() const {
+  const bool newton = time_integrator == "Newton";
+
+  // The linear integrators assemble their matrix once, so neither the
+  // matrix-free operator nor the split Jacobian apply.
+  AssertThrow(newton || !matrix_free,
+              ExcMessage("The matrix-free Jacobian operator requires the "
+                         "Newton time integrator."));
+  AssertThrow(newton || !split_assembly,
+              ExcMessage("Split Jacobian assembly requires the Newton time "
+                         "integrator."));
+
+  // Trilinos matrices only come in double precision.
+  AssertThrow(matrix_free || !mixed_precision,
+              ExcMessage("Mixed precision requires the matrix-free Jacobian "
+                         "operator."));
+
+  // The matrix-free operator never assembles the Jacobian.
+  AssertThrow(!matrix_free || !split_assembly,
+              ExcMessage("Split Jacobian assembly requires the matrix-based "
+                         "Jacobian operator."));
+  AssertThrow(!matrix_free || !lumped_reaction,
+              ExcMessage("The lumped reaction mass requires the matrix-based "
+                         "Jacobian operator."));
+
+  // The row sums of the mass matrix of higher degree elements are zero or
+  // negative at some nodes.
+  AssertThrow(!lumped_reaction || r == 1,
+              ExcMessage("The lumped reaction mass requires degree 1."));
+
+  // Only the assembled Jacobian goes through the cell assembly.
+  AssertThrow(!active_region_assembly || (newton && !matrix_free),
+              ExcMessage("Active region assembly requires the Newton time "
+                         "integrator and the matrix-based Jacobian "
+                         "operator."));
+  AssertThrow(rebalance_interval == 0 || rebalance_cost != "Measured" ||
+                  (newton && !matrix_free),
+              ExcMessage("The measured rebalance cost requires the Newton "
+                         "time integrator and the matrix-based Jacobian "
+                         "operator."));
+
+  // The active region is classified from the ghost values before any cell
+  // is assembled, and the linear integrators never run the Newton assembly.
+  AssertThrow(!communication_overlap || (newton && !active_region_assembly),
+              ExcMessage("Communication overlap requires the Newton time "
+                         "integrator and is not compatible with active "
+                         "region assembly."));
+}
+
 void FisherKolmogorov3D::setup() {
   // Time this entire setup phase
   TimerOutput::Scope t(timer, "Setup");
 
+  AssertThrow(!adaptive_refinement || element_type == "Hexahedra",
+              ExcMessage("Adaptive refinement requires hexahedral elements."));
+  AssertThrow(!adaptive_refinement || snapshot_interval == 0,
+              ExcMessage("Snapshots require a fixed mesh."));
+  // The fully distributed triangulation of the tetrahedra cannot be
+  // repartitioned once created.
+  AssertThrow(rebalance_interval == 0 || element_type == "Hexahedra",
+              ExcMessage("Dynamic rebalancing requires hexahedral elements."));
+  AssertThrow(rebalance_interval == 0 || snapshot_interval == 0,
+              ExcMessage("Snapshots require a fixed partitioning."));
+
+  check_solver_options();
+
   // Create the mesh.
   {
     pcout << "Initializing the mesh" << std::endl;
 
-    Triangulation<dim> mesh_serial;
+    mesh = create_triangulation();
+    create_mesh();
 
-    GridIn<dim> grid_in;
-    grid_in.attach_triangulation(mesh_serial);
-
-    std::ifstream grid_in_file(mesh_file_name);
-    grid_in.read_msh(grid_in_file);
-
-    GridTools::partition_triangulation(mpi_size, mesh_serial);
-    const auto construction_data = TriangulationDescription::Utilities::
-        create_description_from_triangulation(mesh_serial, MPI_COMM_WORLD);
-    mesh.create_triangulation(construction_data);
-
-    pcout << "  Number of elements = " << mesh.n_global_active_cells()
+    pcout << "  Number of elements = " << mesh->n_global_active_cells()
           << std::endl;
   }
 
@@ -50,31 +512,73 @@ void FisherKolmogorov3D::setup() {
   {
     pcout << "Initializing the finite element space" << std::endl;
 
-    fe = std::make_unique<FE_SimplexP<dim>>(r);
+    create_finite_element();
 
     pcout << "  Degree                     = " << fe->degree << std::endl;
     pcout << "  DoFs per cell              = " << fe->dofs_per_cell
           << std::endl;
 
-    quadrature = std::make_unique<QGaussSimplex<dim>>(r + 1);
-
     pcout << "  Quadrature points per cell = " << quadrature->size()
           << std::endl;
   }
 
   pcout << "-----------------------------------------------" << std::endl;
 
+  setup_system();
+}
+
+void FisherKolmogorov3D::create_finite_element() {
+  if (element_type == "Hexahedra") {
+    fe = std::make_unique<FE_Q<dim>>(r);
+    quadrature = std::make_unique<QGauss<dim>>(r + 1);
+    mapping = std::make_unique<MappingQ<dim>>(1);
+  } else {
+    fe = std::make_unique<FE_SimplexP<dim>>(r);
+    quadrature = std::make_unique<QGaussSimplex<dim>>(r + 1);
+    mapping = std::make_unique<MappingFE<dim>>(FE_SimplexP<dim>(1));
+  }
+}
+
+void FisherKolmogorov3D::setup_system() {
   // Initialize the DoF handler.
   {
     pcout << "Initializing the DoF handler" << std::endl;
 
-    dof_handler.reinit(mesh);
+    dof_handler.reinit(*mesh);
     dof_handler.distribute_dofs(*fe);
 
+    if (dof_renumbering != "None")
+      renumber_dofs();
+
     locally_owned_dofs = dof_handler.locally_owned_dofs();
     DoFTools::extract_locally_relevant_dofs(dof_handler, locally_relevant_dofs);
 
+    // No Dirichlet conditions: the only constraints are those of the hanging
+    // nodes of a locally refined mesh.
+    constraints.clear();
+    constraints.reinit(locally_relevant_dofs);
+    DoFTools::make_hanging_node_constraints(dof_handler, constraints);
+    constraints.close();
+
     pcout << "  Number of DoFs = " << dof_handler.n_dofs() << std::endl;
+    pcout << "  Max ghost DoFs per process = "
+          << Utilities::MPI::max(locally_relevant_dofs.n_elements() -
+                                     locally_owned_dofs.n_elements(),
+                                 MPI_COMM_WORLD)
+          << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Evaluate the diffusion tensor once for the whole simulation (or until
+  // the mesh is refined).
+  {
+    pcout << "Caching the diffusion tensor" << std::endl;
+
+    cache_diffusion_tensor();
+
+    pcout << "  Cached tensors = " << diffusion_tensor_cache.size()
+          << std::endl;
   }
 
   pcout << "-----------------------------------------------" << std::endl;
@@ -83,15 +587,82 @@ void FisherKolmogorov3D::setup() {
   {
     pcout << "Initializing the linear system" << std::endl;
 
-    pcout << "  Initializing the sparsity pattern" << std::endl;
-
-    TrilinosWrappers::SparsityPattern sparsity(locally_owned_dofs,
-                                               MPI_COMM_WORLD);
-    DoFTools::make_sparsity_pattern(dof_handler, sparsity);
-    sparsity.compress();
+    if (rebalance_interval > 0 && rebalance_cost == "Measured")
+      cell_cost.assign(mesh->n_active_cells(), 0.0);
+
+    if (matrix_free) {
+      pcout << "  Initializing the matrix-free operator" << std::endl;
+
+      MatrixFree<dim, double>::AdditionalData additional_data;
+      additional_data.tasks_parallel_scheme =
+          MatrixFree<dim, double>::AdditionalData::none;
+      additional_data.mapping_update_flags =
+          update_values | update_gradients | update_JxW_values |
+          update_quadrature_points;
+
+      matrix_free_data = std::make_shared<MatrixFree<dim, double>>();
+      matrix_free_data->reinit(*mapping, dof_handler, constraints, *quadrature,
+                               additional_data);
+
+      jacobian_operator.initialize(matrix_free_data);
+      jacobian_operator.set_coefficients(*d, alpha, deltat);
+      jacobian_operator.set_time_scheme(time_coefficients, newton_theta());
+
+      matrix_free_data->initialize_dof_vector(solution_mf);
+      matrix_free_data->initialize_dof_vector(solution_old_mf);
+      matrix_free_data->initialize_dof_vector(solution_older_mf);
+      matrix_free_data->initialize_dof_vector(residual_mf);
+      matrix_free_data->initialize_dof_vector(delta_mf);
+
+      // The single-precision operator has the same cells and DoFs, and so
+      // the same vector layout. It copies the diffusion tensor of the double
+      // one, so it does not store the quadrature points; the double one
+      // computes the defects from the linearization point, without a
+      // reaction table of its own.
+      if (mixed_precision) {
+        MatrixFree<dim, float>::AdditionalData additional_data_float;
+        additional_data_float.tasks_parallel_scheme =
+            MatrixFree<dim, float>::AdditionalData::none;
+        additional_data_float.mapping_update_flags =
+            update_values | update_gradients | update_JxW_values;
+
+        matrix_free_data_float = std::make_shared<MatrixFree<dim, float>>();
+        matrix_free_data_float->reinit(*mapping, dof_handler, constraints,
+                                       *quadrature, additional_data_float);
+
+        jacobian_operator_float.initialize(matrix_free_data_float);
+        jacobian_operator_float.set_coefficients(jacobian_operator);
+        jacobian_operator_float.set_time_scheme(time_coefficients,
+                                                newton_theta());
+
+        matrix_free_data->initialize_dof_vector(linearization_mf);
+        jacobian_operator.set_linearization_point(linearization_mf);
+
+        matrix_free_data_float->initialize_dof_vector(solution_mf_float);
+        matrix_free_data_float->initialize_dof_vector(residual_mf_float);
+        matrix_free_data_float->initialize_dof_vector(delta_mf_float);
+      }
 
-    pcout << "  Initializing the matrices" << std::endl;
-    jacobian_matrix.reinit(sparsity);
+      pcout << "  Matrix-free memory         = " << matrix_free_memory()
+            << " MB" << std::endl;
+    } else {
+      pcout << "  Initializing the sparsity pattern" << std::endl;
+
+      TrilinosWrappers::SparsityPattern sparsity(locally_owned_dofs,
+                                                 MPI_COMM_WORLD);
+      DoFTools::make_sparsity_pattern(dof_handler, sparsity, constraints,
+                                      false);
+      sparsity.compress();
+
+      pcout << "  Initializing the matrices" << std::endl;
+      jacobian_matrix.reinit(sparsity);
+      if (split_assembly)
+        constant_matrix.reinit(sparsity);
+      if (time_integrator != "Newton") {
+        mass_matrix.reinit(sparsity);
+        stiffness_matrix.reinit(sparsity);
+      }
+    }
 
     pcout << "  Initializing the system right-hand side" << std::endl;
     residual_vector.reinit(locally_owned_dofs, MPI_COMM_WORLD);
@@ -101,195 +672,2298 @@ void FisherKolmogorov3D::setup() {
 
     solution.reinit(locally_owned_dofs, locally_relevant_dofs, MPI_COMM_WORLD);
     solution_old = solution;
+    solution_older = solution;
+
+    // The matrix-free cell loop overlaps the communication by itself.
+    if (communication_overlap && !matrix_free) {
+      pcout << "  Classifying the interior cells" << std::endl;
+      solution_overlap.reinit(locally_owned_dofs, locally_relevant_dofs,
+                              MPI_COMM_WORLD);
+      residual_overlap.reinit(solution_overlap);
+      classify_interior_cells();
+    }
+
+    if (!matrix_free && (split_assembly || lumped_reaction)) {
+      pcout << "  Assembling the time-independent terms" << std::endl;
+      if (lumped_reaction)
+        lumped_mass.reinit(locally_owned_dofs, MPI_COMM_WORLD);
+      assemble_constant_matrix();
+    }
+
+    if (time_integrator != "Newton") {
+      pcout << "  Assembling the mass and stiffness matrices" << std::endl;
+      assemble_linear_operators();
+      update_linear_system_matrix();
+    }
+
+    if (active_region_assembly) {
+      pcout << "  Caching the cell matrices" << std::endl;
+      cache_cell_matrices();
+    }
   }
+
+  // Everything that refers to the previous DoFs is outdated.
+  preconditioner_outdated = true;
+  linearization_valid = false;
+  partitioning.reinit(0);
 }
 
-void FisherKolmogorov3D::assemble_system() {
-  TimerOutput::Scope t(timer, "Assemble system");
+std::unique_ptr<FisherKolmogorov3D::TriangulationType>
+FisherKolmogorov3D::create_triangulation() const {
+  // p4est partitions the mesh along a space-filling curve, and rebalances
+  // it after each refinement.
+  if (element_type == "Hexahedra")
+    return std::make_unique<parallel::distributed::Triangulation<dim>>(
+        MPI_COMM_WORLD, Triangulation<dim>::limit_level_difference_at_vertices);
 
-  const unsigned int dofs_per_cell = fe->dofs_per_cell;
-  const unsigned int n_q = quadrature->size();
+  return std::make_unique<parallel::fullydistributed::Triangulation<dim>>(
+      MPI_COMM_WORLD);
+}
 
-  FEValues<dim> fe_values(*fe, *quadrature,
-                          update_values | update_gradients |
-                              update_quadrature_points | update_JxW_values);
+void FisherKolmogorov3D::create_mesh() {
+  TimerOutput::Scope t(timer, "Create mesh");
 
-  FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-  Vector<double> cell_residual(dofs_per_cell);
+  // The coarse mesh of a distributed triangulation is known to all the
+  // processes, so the hexahedral mesh neither uses the groups nor the cache.
+  if (element_type == "Hexahedra") {
+    create_hexahedral_mesh();
+    return;
+  }
 
-  std::vector<types::global_dof_index> dof_indices(dofs_per_cell);
+  TriangulationDescription::Description<dim, dim> construction_data;
+
+  // Each process caches its own part of the mesh, for a given partitioning
+  // and number of processes.
+  const std::string cache_file =
+      mesh_cache_directory + "/" +
+      std::filesystem::path(mesh_file_name).stem().string() + "." +
+      partitioner + "-" + Utilities::int_to_string(seed_cell_weight) + "." +
+      Utilities::int_to_string(mpi_size) + "." +
+      Utilities::int_to_string(mpi_rank, 4) + ".bin";
+
+  // The cache is used only if all the processes have an up-to-date part.
+  bool cache_valid = false;
+  if (mesh_cache) {
+    const bool local_cache_valid =
+        std::filesystem::exists(cache_file) &&
+        std::filesystem::last_write_time(cache_file) >=
+            std::filesystem::last_write_time(mesh_file_name);
+    cache_valid =
+        Utilities::MPI::min(local_cache_valid ? 1u : 0u, MPI_COMM_WORLD) == 1;
+  }
 
-  jacobian_matrix = 0.0;
-  residual_vector = 0.0;
+  if (cache_valid) {
+    pcout << "  Reading the cached partitioned mesh from "
+          << mesh_cache_directory << std::endl;
+
+    std::ifstream in(cache_file, std::ios::binary);
+    boost::archive::binary_iarchive archive(in);
+    archive >> construction_data;
+
+    // The communicator is not part of the archive.
+    construction_data.comm = MPI_COMM_WORLD;
+  } else {
+    const auto read_mesh = [this](Triangulation<dim> &mesh_serial) {
+      read_serial_mesh(mesh_serial);
+    };
+
+    if (mesh_loading == "Groups") {
+      // Only the first process of each group reads and partitions the mesh,
+      // and sends the other processes of the group their part.
+      const auto partition = [this](Triangulation<dim> &mesh_serial,
+                                    const MPI_Comm comm,
+                                    const unsigned int /*group_size*/) {
+        partition_mesh(mesh_serial, Utilities::MPI::n_mpi_processes(comm));
+      };
+
+      const unsigned int group_size =
+          mesh_group_size == 0 ? mpi_size : mesh_group_size;
+
+      construction_data = TriangulationDescription::Utilities::
+          create_description_from_triangulation_in_groups<dim, dim>(
+              read_mesh, partition, MPI_COMM_WORLD, group_size);
+    } else {
+      Triangulation<dim> mesh_serial;
+      read_mesh(mesh_serial);
 
-  // Value and gradient of the solution on current cell.
-  std::vector<double> solution_loc(n_q);
-  std::vector<Tensor<1, dim>> solution_gradient_loc(n_q);
+      partition_mesh(mesh_serial, mpi_size);
+      construction_data = TriangulationDescription::Utilities::
+          create_description_from_triangulation(mesh_serial, MPI_COMM_WORLD);
+    }
 
-  // Value of the solution at previous timestep (un) on current cell.
-  std::vector<double> solution_old_loc(n_q);
+    if (mesh_cache) {
+      pcout << "  Writing the partitioned mesh to " << mesh_cache_directory
+            << std::endl;
 
-  forcing_term.set_time(time);
+      if (mpi_rank == 0)
+        std::filesystem::create_directories(mesh_cache_directory);
+      MPI_Barrier(MPI_COMM_WORLD);
 
-  for (const auto &cell : dof_handler.active_cell_iterators()) {
-    if (!cell->is_locally_owned())
-      continue;
+      std::ofstream out(cache_file, std::ios::binary);
+      boost::archive::binary_oarchive archive(out);
+      archive << construction_data;
+    }
+  }
 
-    fe_values.reinit(cell);
+  mesh->create_triangulation(construction_data);
+}
 
-    cell_matrix = 0.0;
-    cell_residual = 0.0;
+void FisherKolmogorov3D::read_serial_mesh(
+    Triangulation<dim> &mesh_serial) const {
+  GridIn<dim> grid_in;
+  grid_in.attach_triangulation(mesh_serial);
 
-    fe_values.get_function_values(solution, solution_loc);
-    fe_values.get_function_gradients(solution, solution_gradient_loc);
-    fe_values.get_function_values(solution_old, solution_old_loc);
+  std::ifstream grid_in_file(mesh_file_name);
+  grid_in.read_msh(grid_in_file);
+}
 
-    for (unsigned int q = 0; q < n_q; ++q) {
-      // Evaluate coefficients on this quadrature node.
-      const Tensor<2, dim> d_loc = d.value(fe_values.quadrature_point(q));
+void FisherKolmogorov3D::create_hexahedral_mesh() {
+  Triangulation<dim> mesh_serial;
+  read_serial_mesh(mesh_serial);
 
-      for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-        for (unsigned int j = 0; j < dofs_per_cell; ++j) {
-          // Mass matrix.
-          cell_matrix(i, j) += fe_values.shape_value(i, q) *
-                               fe_values.shape_value(j, q) / deltat *
-                               fe_values.JxW(q);
+  std::vector<Point<dim>> vertices;
+  std::vector<CellData<dim>> cells;
+  build_hexahedral_mesh(mesh_serial, vertices, cells);
 
-          // Non-linear stiffness matrix, first term.
-          cell_matrix(i, j) += d_loc * fe_values.shape_grad(i, q) *
-                               fe_values.shape_grad(j, q) * fe_values.JxW(q);
+  GridTools::invert_all_negative_measure_cells(vertices, cells);
+  GridTools::consistently_order_cells(cells);
 
-          // Non-linear stiffness matrix, second term.
-          cell_matrix(i, j) -= alpha * fe_values.shape_value(i, q) *
-                               (1 - 2 * solution_loc[q]) *
-                               fe_values.shape_value(j, q) * fe_values.JxW(q);
-        }
+  // The cells around the front, or those measured to be expensive, weigh
+  // more when p4est rebalances the mesh.
+  if ((active_region_assembly && active_cell_weight > 1) ||
+      rebalance_interval > 0)
+    mesh->signals.cell_weight.connect(
+        [this](const Triangulation<dim>::cell_iterator &cell,
+               const Triangulation<dim>::CellStatus status) {
+          return cell_weight(cell, status);
+        });
 
-        // Assemble the residual vector (with changed sign).
+  mesh->create_triangulation(vertices, cells, SubCellData());
+}
 
-        // Time derivative term.
-        cell_residual(i) -= (solution_loc[q] - solution_old_loc[q]) / deltat *
-                            fe_values.shape_value(i, q) * fe_values.JxW(q);
+void FisherKolmogorov3D::partition_mesh(Triangulation<dim> &mesh_serial,
+                                        const unsigned int n_partitions) const {
+  std::vector<unsigned int> cell_weights(mesh_serial.n_active_cells(), 1);
+  if (seed_cell_weight != 1)
+    for (const auto &cell : mesh_serial.active_cell_iterators())
+      if (u_0.value(cell->center()) > 0.0)
+        cell_weights[cell->active_cell_index()] = seed_cell_weight;
+
+  if (partitioner == "Hilbert") {
+    std::vector<Triangulation<dim>::active_cell_iterator> cells;
+    std::vector<Point<dim>> centers;
+    for (const auto &cell : mesh_serial.active_cell_iterators()) {
+      cells.push_back(cell);
+      centers.push_back(cell->center());
+    }
 
-        // Diffusion term.
-        cell_residual(i) -= d_loc * fe_values.shape_grad(i, q) *
-                            solution_gradient_loc[q] * fe_values.JxW(q);
+    // Cut the curve into pieces of the same total weight.
+    const double total_weight =
+        std::accumulate(cell_weights.begin(), cell_weights.end(), 0.0);
 
-        // Reaction term.
-        cell_residual(i) += (alpha * solution_loc[q] * (1 - solution_loc[q])) *
-                            fe_values.shape_value(i, q) * fe_values.JxW(q);
-      }
+    double weight = 0.0;
+    for (const unsigned int c : hilbert_order(centers)) {
+      const unsigned int subdomain = std::min<unsigned int>(
+          n_partitions - 1, weight * n_partitions / total_weight);
+      cells[c]->set_subdomain_id(subdomain);
+      weight += cell_weights[c];
     }
+  } else
+    GridTools::partition_triangulation(
+        n_partitions, cell_weights, mesh_serial,
+        partitioner == "Zoltan" ? SparsityTools::Partitioner::zoltan
+                                : SparsityTools::Partitioner::metis);
+}
 
-    cell->get_dof_indices(dof_indices);
+void FisherKolmogorov3D::renumber_dofs() {
+  TimerOutput::Scope t(timer, "Renumber DoFs");
 
-    jacobian_matrix.add(dof_indices, cell_matrix);
-    residual_vector.add(dof_indices, cell_residual);
+  if (dof_renumbering == "Cuthill-McKee") {
+    DoFRenumbering::Cuthill_McKee(dof_handler);
+    return;
   }
 
-  jacobian_matrix.compress(VectorOperation::add);
-  residual_vector.compress(VectorOperation::add);
-}
+  // Sort the locally owned DoFs along a Hilbert curve through their support
+  // points. Each process keeps the same range of indices.
+  const IndexSet owned_dofs = dof_handler.locally_owned_dofs();
 
-void FisherKolmogorov3D::solve_linear_system() {
-  TimerOutput::Scope t(timer, "Solve linear system");
+  std::map<types::global_dof_index, Point<dim>> support_points;
+  DoFTools::map_dofs_to_support_points(*mapping, dof_handler, support_points);
+
+  std::vector<Point<dim>> points(owned_dofs.n_elements());
+  for (const auto &[dof, point] : support_points)
+    if (owned_dofs.is_element(dof))
+      points[owned_dofs.index_within_set(dof)] = point;
 
-  // SolverControl solver_control(1000, 1e-6 * residual_vector.l2_norm());
-  SolverControl solver_control(max_cg_iterations,
-                               cg_tolerance_factor * residual_vector.l2_norm());
+  const std::vector<unsigned int> order = hilbert_order(points);
 
-  SolverCG<TrilinosWrappers::MPI::Vector> solver(solver_control);
-  TrilinosWrappers::PreconditionSSOR preconditioner;
-  preconditioner.initialize(
-      jacobian_matrix, TrilinosWrappers::PreconditionSSOR::AdditionalData(1.0));
+  std::vector<types::global_dof_index> new_numbers(owned_dofs.n_elements());
+  for (unsigned int k = 0; k < order.size(); ++k)
+    new_numbers[order[k]] = owned_dofs.nth_index_in_set(k);
 
-  solver.solve(jacobian_matrix, delta_owned, residual_vector, preconditioner);
-  pcout << "  " << solver_control.last_step() << " CG iterations" << std::endl;
+  dof_handler.renumber_dofs(new_numbers);
 }
 
-void FisherKolmogorov3D::solve_newton() {
-  TimerOutput::Scope t(timer, "Solve nonlinear (Newton)");
+SymmetricTensor<2, FisherKolmogorov3D::dim>
+FisherKolmogorov3D::diffusion_tensor(const Point<dim> &p) const {
+  return SymmetricTensor<2, dim>(d->value(p));
+}
 
-  unsigned int n_iter = 0;
-  double residual_norm = newton_tolerance + 1;
+void FisherKolmogorov3D::cache_diffusion_tensor() {
+  const unsigned int n_q = quadrature->size();
 
-  while (n_iter < max_newton_iterations && residual_norm > newton_tolerance) {
-    assemble_system();
-    residual_norm = residual_vector.l2_norm();
+  FEValues<dim> fe_values(*fe, *quadrature, update_quadrature_points);
 
-    pcout << "  Newton iteration " << n_iter << "/" << max_newton_iterations
-          << " - ||r|| = " << std::scientific << std::setprecision(6)
-          << residual_norm << std::flush;
+  diffusion_tensor_cache.assign(mesh->n_active_cells() * n_q,
+                                SymmetricTensor<2, dim>());
 
-    // We actually solve the system only if the residual is larger than the
-    // tolerance.
-    if (residual_norm > newton_tolerance) {
-      solve_linear_system();
+  // Tensors evaluated on the current cell. Going through value_list() lets
+  // data-driven tensors look up all the points of a cell at once.
+  std::vector<Tensor<2, dim>> d_values(n_q);
 
-      solution_owned += delta_owned;
-      solution = solution_owned;
-    } else {
-      pcout << " < tolerance" << std::endl;
-    }
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (!cell->is_locally_owned())
+      continue;
 
-    ++n_iter;
+    fe_values.reinit(cell);
+    d->value_list(fe_values.get_quadrature_points(), d_values);
+
+    const unsigned int offset = cell->active_cell_index() * n_q;
+    for (unsigned int q = 0; q < n_q; ++q)
+      diffusion_tensor_cache[offset + q] = SymmetricTensor<2, dim>(d_values[q]);
   }
 }
 
-void FisherKolmogorov3D::output(const unsigned int &time_step) const {
-  TimerOutput::Scope t(timer, "Writing");
+void FisherKolmogorov3D::cache_cell_matrices() {
+  TimerOutput::Scope t(timer, "Cache cell matrices");
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  const unsigned int n_q = quadrature->size();
+
+  FEValues<dim> fe_values(*fe, *quadrature,
+                          update_values | update_gradients | update_JxW_values);
 
-  DataOut<dim> data_out;
-  data_out.add_data_vector(dof_handler, solution, "u");
+  // Only the locally owned cells are cached: the active cells of a p4est
+  // mesh also include the artificial coarse cells of the whole domain.
+  cell_cache_index.assign(mesh->n_active_cells(),
+                          numbers::invalid_unsigned_int);
+  unsigned int n_owned = 0;
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    if (cell->is_locally_owned())
+      cell_cache_index[cell->active_cell_index()] = n_owned++;
 
-  std::vector<unsigned int> partition_int(mesh.n_active_cells());
-  GridTools::get_subdomain_association(mesh, partition_int);
-  const Vector<double> partitioning(partition_int.begin(), partition_int.end());
-  data_out.add_data_vector(partitioning, "partitioning");
+  cell_mass_cache.assign(n_owned * dofs_per_cell * dofs_per_cell, 0.0);
+  cell_stiffness_cache.assign(cell_mass_cache.size(), 0.0);
 
-  data_out.build_patches();
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (!cell->is_locally_owned())
+      continue;
+
+    fe_values.reinit(cell);
+
+    const unsigned int offset = cell->active_cell_index() * n_q;
+    const unsigned int cache_offset =
+        cell_cache_index[cell->active_cell_index()] * dofs_per_cell *
+        dofs_per_cell;
+    double *cell_mass = &cell_mass_cache[cache_offset];
+    double *cell_stiffness = &cell_stiffness_cache[cache_offset];
+
+    for (unsigned int q = 0; q < n_q; ++q) {
+      const SymmetricTensor<2, dim> &d_loc = diffusion_tensor_cache[offset + q];
 
-  data_out.write_vtu_with_pvtu_record("./", "output", time_step, MPI_COMM_WORLD,
-                                      3);
+      for (unsigned int i = 0; i < dofs_per_cell; ++i)
+        for (unsigned int j = 0; j < dofs_per_cell; ++j) {
+          cell_mass[i * dofs_per_cell + j] += fe_values.shape_value(i, q) *
+                                              fe_values.shape_value(j, q) *
+                                              fe_values.JxW(q);
+          cell_stiffness[i * dofs_per_cell + j] +=
+              d_loc * fe_values.shape_grad(i, q) * fe_values.shape_grad(j, q) *
+              fe_values.JxW(q);
+        }
+    }
+  }
 }
 
-void FisherKolmogorov3D::solve() {
-  TimerOutput::Scope t(timer, "Time loop (solve)");
+void FisherKolmogorov3D::update_active_region() {
+  TimerOutput::Scope t(timer, "Update active region");
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
 
-  pcout << "===============================================" << std::endl;
+  Vector<double> solution_loc(dofs_per_cell);
+  Vector<double> solution_old_loc(dofs_per_cell);
+  Vector<double> solution_older_loc(dofs_per_cell);
+
+  // BDF2 also reads the solution two steps before.
+  const bool bdf2 = time_coefficients[2] != 0.0;
+
+  // Whether all the values are within tolerance of the given plateau.
+  const auto on_plateau = [this](const Vector<double> &values,
+                                 const double plateau) {
+    for (const double v : values)
+      if (std::abs(v - plateau) > active_region_tolerance)
+        return false;
+    return true;
+  };
+
+  // Ghost cells are classified too, so that the halo crosses the process
+  // boundaries.
+  cell_state.assign(mesh->n_active_cells(), active_cell_state);
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (cell->is_artificial())
+      continue;
 
-  time = 0.0;
+    cell->get_dof_values(solution, solution_loc);
+    cell->get_dof_values(solution_old, solution_old_loc);
+    if (bdf2)
+      cell->get_dof_values(solution_older, solution_older_loc);
 
-  // Apply the initial condition.
-  {
-    pcout << "Applying the initial condition" << std::endl;
+    for (const signed char plateau : {0, 1})
+      if (on_plateau(solution_loc, plateau) &&
+          on_plateau(solution_old_loc, plateau) &&
+          (!bdf2 || on_plateau(solution_older_loc, plateau)))
+        cell_state[cell->active_cell_index()] = plateau;
+  }
 
-    VectorTools::interpolate(dof_handler, u_0, solution_owned);
-    solution = solution_owned;
+  // Layers of cells around the front.
+  std::vector<DoFHandler<dim>::active_cell_iterator> neighbors;
+  for (unsigned int layer = 0; layer < active_region_halo; ++layer) {
+    std::vector<signed char> new_state(cell_state);
 
-    // Output the initial solution.
-    output(0);
-    pcout << "-----------------------------------------------" << std::endl;
+    for (const auto &cell : dof_handler.active_cell_iterators()) {
+      if (cell->is_artificial() ||
+          cell_state[cell->active_cell_index()] != active_cell_state)
+        continue;
+
+      GridTools::get_active_neighbors<DoFHandler<dim>>(cell, neighbors);
+      for (const auto &neighbor : neighbors)
+        if (!neighbor->is_artificial())
+          new_state[neighbor->active_cell_index()] = active_cell_state;
+    }
+
+    cell_state = std::move(new_state);
   }
 
-  unsigned int time_step = 0;
+  active_cell_ids.clear();
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    if (cell->is_locally_owned() &&
+        cell_state[cell->active_cell_index()] == active_cell_state)
+      active_cell_ids.insert(cell->id());
+
+  const double n_active = active_cell_ids.size();
+  active_cell_fraction = Utilities::MPI::sum(n_active, MPI_COMM_WORLD) /
+                         mesh->n_global_active_cells();
+  active_cell_imbalance =
+      Utilities::MPI::max(n_active, MPI_COMM_WORLD) /
+      std::max(Utilities::MPI::sum(n_active, MPI_COMM_WORLD) / mpi_size, 1.0);
+}
 
-  while (time < T - 0.5 * deltat) {
-    time += deltat;
-    ++time_step;
+void FisherKolmogorov3D::assemble_constant_matrix() {
+  TimerOutput::Scope t(timer, "Assemble constant matrix");
 
-    // Store the old solution, so that it is available for assembly.
-    solution_old = solution;
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  const unsigned int n_q = quadrature->size();
 
-    pcout << "n = " << std::setw(3) << time_step << ", t = " << std::setw(5)
-          << std::fixed << time << std::endl;
+  FEValues<dim> fe_values(*fe, *quadrature,
+                          update_values | update_gradients | update_JxW_values);
 
-    // At every time step, we invoke Newton's method to solve the non-linear
-    // problem.
-    solve_newton();
+  FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
+  Vector<double> cell_lumped_mass(dofs_per_cell);
 
-    output(time_step);
+  std::vector<types::global_dof_index> dof_indices(dofs_per_cell);
 
-    pcout << std::endl;
-  }
-}
\ No newline at end of file
+  const double mass_coefficient = time_coefficients[0] / deltat;
+  const double theta_n = newton_theta();
+
+  if (split_assembly)
+    constant_matrix = 0.0;
+  if (lumped_reaction)
+    lumped_mass = 0.0;
+
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (!cell->is_locally_owned())
+      continue;
+
+    fe_values.reinit(cell);
+
+    cell_matrix = 0.0;
+    cell_lumped_mass = 0.0;
+
+    const unsigned int offset = cell->active_cell_index() * n_q;
+
+    for (unsigned int q = 0; q < n_q; ++q) {
+      const SymmetricTensor<2, dim> &d_loc = diffusion_tensor_cache[offset + q];
+
+      for (unsigned int i = 0; i < dofs_per_cell; ++i) {
+        for (unsigned int j = 0; j < dofs_per_cell && split_assembly; ++j) {
+          // Mass matrix.
+          cell_matrix(i, j) += mass_coefficient * fe_values.shape_value(i, q) *
+                               fe_values.shape_value(j, q) * fe_values.JxW(q);
+
+          // Stiffness matrix.
+          cell_matrix(i, j) += theta_n * d_loc * fe_values.shape_grad(i, q) *
+                               fe_values.shape_grad(j, q) * fe_values.JxW(q);
+        }
+
+        // Row sum of the mass matrix: the shape functions sum up to one.
+        cell_lumped_mass(i) += fe_values.shape_value(i, q) * fe_values.JxW(q);
+      }
+    }
+
+    cell->get_dof_indices(dof_indices);
+
+    if (split_assembly)
+      constraints.distribute_local_to_global(cell_matrix, dof_indices,
+                                             constant_matrix);
+    if (lumped_reaction)
+      constraints.distribute_local_to_global(cell_lumped_mass, dof_indices,
+                                             lumped_mass);
+  }
+
+  if (split_assembly)
+    constant_matrix.compress(VectorOperation::add);
+  if (lumped_reaction)
+    lumped_mass.compress(VectorOperation::add);
+}
+
+void FisherKolmogorov3D::assemble_linear_operators() {
+  TimerOutput::Scope t(timer, "Assemble constant matrix");
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  const unsigned int n_q = quadrature->size();
+
+  FEValues<dim> fe_values(*fe, *quadrature,
+                          update_values | update_gradients | update_JxW_values);
+
+  FullMatrix<double> cell_mass_matrix(dofs_per_cell, dofs_per_cell);
+  FullMatrix<double> cell_stiffness_matrix(dofs_per_cell, dofs_per_cell);
+
+  std::vector<types::global_dof_index> dof_indices(dofs_per_cell);
+
+  mass_matrix = 0.0;
+  stiffness_matrix = 0.0;
+
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (!cell->is_locally_owned())
+      continue;
+
+    fe_values.reinit(cell);
+
+    cell_mass_matrix = 0.0;
+    cell_stiffness_matrix = 0.0;
+
+    const unsigned int offset = cell->active_cell_index() * n_q;
+
+    for (unsigned int q = 0; q < n_q; ++q) {
+      const SymmetricTensor<2, dim> &d_loc = diffusion_tensor_cache[offset + q];
+
+      for (unsigned int i = 0; i < dofs_per_cell; ++i) {
+        for (unsigned int j = 0; j < dofs_per_cell; ++j) {
+          cell_mass_matrix(i, j) += fe_values.shape_value(i, q) *
+                                    fe_values.shape_value(j, q) *
+                                    fe_values.JxW(q);
+
+          cell_stiffness_matrix(i, j) += d_loc * fe_values.shape_grad(i, q) *
+                                         fe_values.shape_grad(j, q) *
+                                         fe_values.JxW(q);
+        }
+      }
+    }
+
+    cell->get_dof_indices(dof_indices);
+
+    constraints.distribute_local_to_global(cell_mass_matrix, dof_indices,
+                                           mass_matrix);
+    constraints.distribute_local_to_global(cell_stiffness_matrix, dof_indices,
+                                           stiffness_matrix);
+  }
+
+  mass_matrix.compress(VectorOperation::add);
+  stiffness_matrix.compress(VectorOperation::add);
+}
+
+void FisherKolmogorov3D::assemble_mass_and_stiffness(
+    TrilinosWrappers::SparseMatrix &mass,
+    TrilinosWrappers::SparseMatrix &stiffness) {
+  AssertThrow(!matrix_free,
+              ExcMessage("The mass and stiffness matrices require the "
+                         "matrix-based Jacobian operator."));
+
+  // The linear integrators already have the matrices.
+  if (mass_matrix.m() == 0) {
+    mass_matrix.reinit(jacobian_matrix);
+    stiffness_matrix.reinit(jacobian_matrix);
+  }
+
+  assemble_linear_operators();
+  if (time_integrator != "Newton")
+    update_linear_system_matrix();
+
+  mass.copy_from(mass_matrix);
+  stiffness.copy_from(stiffness_matrix);
+}
+
+void FisherKolmogorov3D::interpolate_initial_condition(
+    TrilinosWrappers::MPI::Vector &dst) const {
+  dst.reinit(locally_owned_dofs, MPI_COMM_WORLD);
+  VectorTools::interpolate(dof_handler, u_0, dst);
+}
+
+void FisherKolmogorov3D::initial_condition(
+    TrilinosWrappers::MPI::Vector &u_0_owned) {
+  VectorTools::interpolate(dof_handler, u_0, u_0_owned);
+}
+
+void FisherKolmogorov3D::update_linear_system_matrix() {
+  jacobian_matrix.copy_from(mass_matrix);
+  jacobian_matrix *= 1.0 / deltat;
+  jacobian_matrix.add(theta, stiffness_matrix);
+
+  // The matrix only changes with the time step, and so does its
+  // preconditioner.
+  preconditioner_outdated = true;
+}
+
+FisherKolmogorov3D::AssemblyScratchData::AssemblyScratchData(
+    const FiniteElement<dim> &fe, const Quadrature<dim> &quadrature,
+    const UpdateFlags update_flags)
+    : fe_values(fe, quadrature, update_flags),
+      solution_loc(quadrature.size()),
+      solution_gradient_loc(quadrature.size()),
+      solution_old_loc(quadrature.size()),
+      solution_old_gradient_loc(quadrature.size()),
+      solution_older_loc(quadrature.size()), dof_values(fe.dofs_per_cell),
+      dof_values_old(fe.dofs_per_cell), dof_values_older(fe.dofs_per_cell),
+      mass_values(fe.dofs_per_cell), stiffness_values(fe.dofs_per_cell) {}
+
+FisherKolmogorov3D::AssemblyScratchData::AssemblyScratchData(
+    const AssemblyScratchData &scratch_data)
+    : fe_values(scratch_data.fe_values.get_fe(),
+                scratch_data.fe_values.get_quadrature(),
+                scratch_data.fe_values.get_update_flags()),
+      solution_loc(scratch_data.solution_loc.size()),
+      solution_gradient_loc(scratch_data.solution_gradient_loc.size()),
+      solution_old_loc(scratch_data.solution_old_loc.size()),
+      solution_old_gradient_loc(
+          scratch_data.solution_old_gradient_loc.size()),
+      solution_older_loc(scratch_data.solution_older_loc.size()),
+      dof_values(scratch_data.dof_values.size()),
+      dof_values_old(scratch_data.dof_values_old.size()),
+      dof_values_older(scratch_data.dof_values_older.size()),
+      mass_values(scratch_data.mass_values.size()),
+      stiffness_values(scratch_data.stiffness_values.size()) {}
+
+bool FisherKolmogorov3D::assemble_cell_matrix() const {
+  // With split assembly and lumped reaction, no cell matrix is needed at all.
+  return jacobian_assembly && !matrix_free &&
+         !(split_assembly && lumped_reaction);
+}
+
+void FisherKolmogorov3D::assemble_system(const bool assemble_jacobian) {
+  TimerOutput::Scope t(timer, assemble_jacobian ? "Assemble system"
+                                                : "Assemble residual");
+  ScopedMetric m(metric(step_metrics.assembly));
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+
+  jacobian_assembly = assemble_jacobian;
+  if (jacobian_assembly)
+    ++jacobian_assemblies_total;
+
+  // The matrix-free operator evaluates the residual with its own vectorized
+  // cell kernels, so the FEValues cell loop below is only needed for the
+  // assembled Jacobian.
+  if (matrix_free) {
+    // With the overlap, the cell loop exchanges the ghost values of the
+    // iterate itself, while it works on the cells that do not need them.
+    copy_locally_owned(solution_mf, solution_owned, locally_owned_dofs);
+    if (communication_overlap)
+      solution_mf.zero_out_ghosts();
+    else
+      solution_mf.update_ghost_values();
+    copy_locally_owned(solution_old_mf, solution_old, locally_owned_dofs);
+    solution_old_mf.update_ghost_values();
+    if (time_coefficients[2] != 0.0) {
+      copy_locally_owned(solution_older_mf, solution_older,
+                         locally_owned_dofs);
+      solution_older_mf.update_ghost_values();
+    }
+
+    jacobian_operator.evaluate_residual(residual_mf, solution_mf,
+                                        solution_old_mf, solution_older_mf);
+
+    copy_locally_owned(residual_vector, residual_mf, locally_owned_dofs);
+    residual_vector.compress(VectorOperation::insert);
+    return;
+  }
+
+  if (active_region_assembly)
+    update_active_region();
+
+  // Start from the precomputed time-independent part, if available.
+  if (!matrix_free && jacobian_assembly) {
+    if (split_assembly)
+      jacobian_matrix.copy_from(constant_matrix);
+    else
+      jacobian_matrix = 0.0;
+  }
+  residual_vector = 0.0;
+
+  // Cells are assembled concurrently by the worker threads, while the copier
+  // adds their contributions to the global system one at a time.
+  using CellFilter = FilteredIterator<DoFHandler<dim>::active_cell_iterator>;
+
+  AssemblyScratchData scratch_data(*fe, *quadrature,
+                                   update_values | update_gradients |
+                                       update_JxW_values);
+
+  AssemblyCopyData copy_data;
+  copy_data.cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+  copy_data.cell_residual.reinit(dofs_per_cell);
+  copy_data.dof_indices.resize(dofs_per_cell);
+
+  if (communication_overlap) {
+    using CellIterator =
+        std::vector<DoFHandler<dim>::active_cell_iterator>::const_iterator;
+
+    const auto assemble_cells = [&](const CellIterator &begin,
+                                    const CellIterator &end) {
+      WorkStream::run(
+          begin, end,
+          [this](const CellIterator &cell, AssemblyScratchData &scratch,
+                 AssemblyCopyData &copy) {
+            local_assemble_system(*cell, scratch, copy);
+          },
+          [this](const AssemblyCopyData &copy) { copy_local_to_global(copy); },
+          scratch_data, copy_data);
+    };
+
+    // The first half of the interior cells is assembled while the ghost
+    // values of the iterate are exchanged, and the second half while the
+    // contributions of the boundary cells to the ghost entries are sent to
+    // their owners.
+    const CellIterator interior_middle =
+        interior_cells.cbegin() + interior_cells.size() / 2;
+
+    copy_locally_owned(solution_overlap, solution_owned, locally_owned_dofs);
+    solution_overlap.update_ghost_values_start();
+    residual_overlap = 0.0;
+
+    assemble_cells(interior_cells.cbegin(), interior_middle);
+    {
+      ScopedMetric m_ghost(metric(step_metrics.ghost_exchange));
+      solution_overlap.update_ghost_values_finish();
+    }
+
+    assemble_cells(boundary_cells.cbegin(), boundary_cells.cend());
+    residual_overlap.compress_start(0, VectorOperation::add);
+
+    assemble_cells(interior_middle, interior_cells.cend());
+    {
+      ScopedMetric m_ghost(metric(step_metrics.ghost_exchange));
+      residual_overlap.compress_finish(VectorOperation::add);
+    }
+  } else
+    WorkStream::run(
+        CellFilter(IteratorFilters::LocallyOwnedCell(),
+                   dof_handler.begin_active()),
+        CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+        [this](const DoFHandler<dim>::active_cell_iterator &cell,
+               AssemblyScratchData &scratch, AssemblyCopyData &copy) {
+          local_assemble_system(cell, scratch, copy);
+        },
+        [this](const AssemblyCopyData &copy) { copy_local_to_global(copy); },
+        scratch_data, copy_data);
+
+  // Lumped reaction term, evaluated at the nodes.
+  if (lumped_reaction) {
+    const double theta_n = newton_theta();
+
+    for (const auto i : locally_owned_dofs) {
+      const double u_i = solution_owned(i);
+      const double u_old_i = solution_old(i);
+      const double m_i = lumped_mass(i);
+
+      if (jacobian_assembly)
+        jacobian_matrix.add(i, i, -theta_n * alpha * (1 - 2 * u_i) * m_i);
+
+      const double reaction =
+          (theta_n * alpha * u_i * (1 - u_i) +
+           (1 - theta_n) * alpha * u_old_i * (1 - u_old_i)) *
+          m_i;
+      if (communication_overlap)
+        residual_overlap(i) += reaction;
+      else
+        residual_vector(i) += reaction;
+    }
+  }
+
+  // The matrix has no split compression: its ghost rows are still sent
+  // with a blocking exchange.
+  if (!matrix_free && jacobian_assembly)
+    jacobian_matrix.compress(VectorOperation::add);
+
+  if (communication_overlap) {
+    copy_locally_owned(residual_vector, residual_overlap, locally_owned_dofs);
+    residual_vector.compress(VectorOperation::insert);
+  } else
+    residual_vector.compress(VectorOperation::add);
+}
+
+void FisherKolmogorov3D::local_assemble_system(
+    const DoFHandler<dim>::active_cell_iterator &cell,
+    AssemblyScratchData &scratch, AssemblyCopyData &copy_data) {
+  FEValues<dim> &fe_values = scratch.fe_values;
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  const unsigned int n_q = quadrature->size();
+
+  const bool cell_matrix_needed = assemble_cell_matrix();
+
+  // Value and gradient of the solution on current cell.
+  std::vector<double> &solution_loc = scratch.solution_loc;
+  std::vector<Tensor<1, dim>> &solution_gradient_loc =
+      scratch.solution_gradient_loc;
+
+  // Value of the solution at previous timestep (un) on current cell.
+  std::vector<double> &solution_old_loc = scratch.solution_old_loc;
+
+  // Gradient of un, and value of the solution two timesteps before.
+  std::vector<Tensor<1, dim>> &solution_old_gradient_loc =
+      scratch.solution_old_gradient_loc;
+  std::vector<double> &solution_older_loc = scratch.solution_older_loc;
+
+  // Time derivative (a0 u + a1 un + a2 unn) / deltat, and weight of the
+  // implicit part of the diffusion and reaction terms.
+  const double a0 = time_coefficients[0] / deltat;
+  const double a1 = time_coefficients[1] / deltat;
+  const double a2 = time_coefficients[2] / deltat;
+  const double theta_n = newton_theta();
+
+  FullMatrix<double> &cell_matrix = copy_data.cell_matrix;
+  Vector<double> &cell_residual = copy_data.cell_residual;
+
+  // Measured cost of the cell, for the rebalancing. Each cell is assembled
+  // by a single thread, so the entries are not shared.
+  ScopedMetric cost(cell_cost.empty() ? nullptr
+                                      : &cell_cost[cell->active_cell_index()]);
+
+  // Away from the front u is within active_region_tolerance of a plateau p
+  // (0 or 1) at all the time steps of the scheme. The Jacobian
+  // M_c (a0 / deltat - theta alpha (1 - 2 p)) + theta K_c and the residual
+  // come from the cached cell matrices, without the quadrature loop. The
+  // residual is that of the quadrature loop, except for the reaction
+  // u (1 - u), replaced by its linearization (1 - 2 p) (u - p) at the
+  // plateau: the difference is below alpha tolerance^2 per node.
+  if (active_region_assembly) {
+    const signed char state = cell_state[cell->active_cell_index()];
+
+    if (state != active_cell_state) {
+      const unsigned int offset = cell_cache_index[cell->active_cell_index()] *
+                                  dofs_per_cell * dofs_per_cell;
+      const double *cell_mass = &cell_mass_cache[offset];
+      const double *cell_stiffness = &cell_stiffness_cache[offset];
+
+      if (cell_matrix_needed) {
+        const double reaction =
+            lumped_reaction ? 0.0 : theta_n * alpha * (1 - 2 * state);
+        const double mass_factor = (split_assembly ? 0.0 : a0) - reaction;
+        const double stiffness_factor = split_assembly ? 0.0 : theta_n;
+
+        for (unsigned int i = 0; i < dofs_per_cell; ++i)
+          for (unsigned int j = 0; j < dofs_per_cell; ++j) {
+            const unsigned int ij = i * dofs_per_cell + j;
+            cell_matrix(i, j) = mass_factor * cell_mass[ij] +
+                                stiffness_factor * cell_stiffness[ij];
+          }
+      }
+
+      // Nodal values of the terms multiplied by M_c and K_c.
+      Vector<double> &u = scratch.dof_values;
+      Vector<double> &u_old = scratch.dof_values_old;
+      Vector<double> &u_older = scratch.dof_values_older;
+      cell->get_dof_values(solution, u);
+      cell->get_dof_values(solution_old, u_old);
+      if (a2 != 0.0)
+        cell->get_dof_values(solution_older, u_older);
+
+      for (unsigned int j = 0; j < dofs_per_cell; ++j) {
+        double mass_term = a0 * u[j] + a1 * u_old[j];
+        if (a2 != 0.0)
+          mass_term += a2 * u_older[j];
+        if (!lumped_reaction)
+          mass_term -= alpha * (1 - 2 * state) *
+                       (theta_n * (u[j] - state) +
+                        (1 - theta_n) * (u_old[j] - state));
+
+        scratch.mass_values[j] = mass_term;
+        scratch.stiffness_values[j] =
+            theta_n * u[j] + (1 - theta_n) * u_old[j];
+      }
+
+      for (unsigned int i = 0; i < dofs_per_cell; ++i) {
+        double r_i = 0.0;
+        for (unsigned int j = 0; j < dofs_per_cell; ++j) {
+          const unsigned int ij = i * dofs_per_cell + j;
+          r_i += cell_mass[ij] * scratch.mass_values[j] +
+                 cell_stiffness[ij] * scratch.stiffness_values[j];
+        }
+        cell_residual(i) = -r_i;
+      }
+
+      cell->get_dof_indices(copy_data.dof_indices);
+      return;
+    }
+  }
+
+  fe_values.reinit(cell);
+
+  // The overlapped assembly reads the iterate from its own ghosted vector.
+  if (communication_overlap) {
+    fe_values.get_function_values(solution_overlap, solution_loc);
+    fe_values.get_function_gradients(solution_overlap, solution_gradient_loc);
+  } else {
+    fe_values.get_function_values(solution, solution_loc);
+    fe_values.get_function_gradients(solution, solution_gradient_loc);
+  }
+  fe_values.get_function_values(solution_old, solution_old_loc);
+  if (theta_n < 1.0)
+    fe_values.get_function_gradients(solution_old, solution_old_gradient_loc);
+  if (a2 != 0.0)
+    fe_values.get_function_values(solution_older, solution_older_loc);
+
+  // Quadrature loop of the kernel shared with the 1D and convergence
+  // solvers, with the reaction left to the lumped assembly and a0 M +
+  // theta K to the split assembly when they are on.
+  CellKernelData<dim> data;
+  data.u = solution_loc.data();
+  data.u_gradient = solution_gradient_loc.data();
+  data.u_old = solution_old_loc.data();
+  data.u_old_gradient = solution_old_gradient_loc.data();
+  data.u_older = solution_older_loc.data();
+  data.d = &diffusion_tensor_cache[cell->active_cell_index() * n_q];
+
+  CellKernelCoefficients coefficients;
+  coefficients.a0 = a0;
+  coefficients.a1 = a1;
+  coefficients.a2 = a2;
+  coefficients.theta = theta_n;
+  coefficients.alpha = alpha;
+  // The matrix-free operator applies the Jacobian on the fly.
+  coefficients.matrix = cell_matrix_needed;
+  coefficients.mass_and_stiffness = !split_assembly;
+  coefficients.reaction = !lumped_reaction;
+
+  fisher_kolmogorov_cell(fe_values, data, coefficients, cell_matrix,
+                         cell_residual);
+
+  cell->get_dof_indices(copy_data.dof_indices);
+}
+
+void FisherKolmogorov3D::copy_local_to_global(
+    const AssemblyCopyData &copy_data) {
+  if (assemble_cell_matrix())
+    constraints.distribute_local_to_global(copy_data.cell_matrix,
+                                           copy_data.dof_indices,
+                                           jacobian_matrix);
+  if (communication_overlap)
+    constraints.distribute_local_to_global(copy_data.cell_residual,
+                                           copy_data.dof_indices,
+                                           residual_overlap);
+  else
+    constraints.distribute_local_to_global(copy_data.cell_residual,
+                                           copy_data.dof_indices,
+                                           residual_vector);
+}
+
+void FisherKolmogorov3D::classify_interior_cells() {
+  std::vector<types::global_dof_index> dof_indices(fe->dofs_per_cell);
+
+  interior_cells.clear();
+  boundary_cells.clear();
+
+  for (const auto &cell : dof_handler.active_cell_iterators()) {
+    if (!cell->is_locally_owned())
+      continue;
+
+    cell->get_dof_indices(dof_indices);
+
+    // A hanging node adds its contributions to the DoFs it is constrained
+    // to, which may be ghosts.
+    const bool interior = std::all_of(
+        dof_indices.begin(), dof_indices.end(),
+        [this](const types::global_dof_index i) {
+          return locally_owned_dofs.is_element(i) &&
+                 !constraints.is_constrained(i);
+        });
+
+    (interior ? interior_cells : boundary_cells).push_back(cell);
+  }
+
+  const double n_interior = interior_cells.size();
+  pcout << "  Interior cells = " << std::fixed << std::setprecision(1)
+        << 100.0 * Utilities::MPI::sum(n_interior, MPI_COMM_WORLD) /
+               mesh->n_global_active_cells()
+        << "%" << std::endl;
+}
+
+void FisherKolmogorov3D::setup_preconditioner() {
+  TimerOutput::Scope t(timer, "Setup preconditioner");
+  ScopedMetric m(metric(step_metrics.preconditioner_setup));
+
+  if (preconditioner_type == "AMG") {
+    TrilinosWrappers::PreconditionAMG::AdditionalData data;
+    data.elliptic = true;
+    data.higher_order_elements = (r > 1);
+    data.smoother_type = amg_smoother_type.c_str();
+    data.smoother_sweeps = amg_smoother_sweeps;
+    data.aggregation_threshold = amg_aggregation_threshold;
+
+    auto amg = std::make_unique<TrilinosWrappers::PreconditionAMG>();
+    amg->initialize(jacobian_matrix, data);
+    preconditioner = std::move(amg);
+  } else if (preconditioner_type == "ILU") {
+    auto ilu = std::make_unique<TrilinosWrappers::PreconditionILU>();
+    ilu->initialize(jacobian_matrix,
+                    TrilinosWrappers::PreconditionILU::AdditionalData());
+    preconditioner = std::move(ilu);
+  } else {
+    auto ssor = std::make_unique<TrilinosWrappers::PreconditionSSOR>();
+    ssor->initialize(jacobian_matrix,
+                     TrilinosWrappers::PreconditionSSOR::AdditionalData(1.0));
+    preconditioner = std::move(ssor);
+  }
+
+  preconditioner_outdated = false;
+}
+
+bool FisherKolmogorov3D::operator_cache_valid() const {
+  // The cache is disabled: skip the collective below, which would otherwise
+  // run in every Newton iteration.
+  if (operator_cache_threshold <= 0.0)
+    return false;
+
+  // a0 M / deltat changes with the time step and the time scheme.
+  const double mass_coefficient = time_coefficients[0] / deltat;
+  if (!linearization_valid ||
+      mass_coefficient != linearization_mass_coefficient)
+    return false;
+
+  // Only the reaction block -theta alpha (1 - 2 u) M of the Jacobian depends
+  // on the solution. Its change, relative to the mass term a0 M / deltat, is
+  // bounded by 2 theta alpha deltat / a0 max |u - u_cached|. The maximum
+  // is taken over the owned entries directly, without a work vector.
+  double local_change = 0.0;
+  auto u = solution_owned.begin();
+  auto u_cached = linearization_point.begin();
+  for (; u != solution_owned.end(); ++u, ++u_cached)
+    local_change = std::max(local_change, std::abs(*u - *u_cached));
+
+  const double change = Utilities::MPI::max(local_change, MPI_COMM_WORLD);
+
+  return 2.0 * newton_theta() * alpha * change / mass_coefficient <=
+         operator_cache_threshold;
+}
+
+void FisherKolmogorov3D::record_operator_cache(const bool hit) {
+  if (hit)
+    ++operator_cache_hits;
+  else
+    ++operator_cache_misses;
+}
+
+unsigned int
+FisherKolmogorov3D::solve_tangent_problem(SolverControl &solver_control) {
+  TimerOutput::Scope t(timer, "Solve linear system");
+  ScopedMetric m(metric(step_metrics.linear_solve));
+
+  if (matrix_free) {
+    // Linearize the operator around the current Newton iterate, unless the
+    // previous linearization is being reused.
+    if (jacobian_assembly) {
+      // In mixed precision only the single-precision operator is linearized
+      // and preconditioned; the double one only computes the defects, from
+      // its own copy of the iterate, since the residual overwrites
+      // solution_mf while the linearization may be reused.
+      if (mixed_precision) {
+        copy_locally_owned(linearization_mf, solution_owned,
+                           locally_owned_dofs);
+        solution_mf_float.copy_locally_owned_data_from(linearization_mf);
+        {
+          ScopedMetric m_ghost(metric(step_metrics.ghost_exchange));
+          linearization_mf.update_ghost_values();
+          solution_mf_float.update_ghost_values();
+        }
+        jacobian_operator_float.evaluate_newton_step(solution_mf_float);
+        jacobian_operator_float.compute_diagonal();
+      } else {
+        copy_locally_owned(solution_mf, solution_owned, locally_owned_dofs);
+        {
+          ScopedMetric m_ghost(metric(step_metrics.ghost_exchange));
+          solution_mf.update_ghost_values();
+        }
+        jacobian_operator.evaluate_newton_step(solution_mf);
+        jacobian_operator.compute_diagonal();
+      }
+    }
+
+    copy_locally_owned(residual_mf, residual_vector, locally_owned_dofs);
+    delta_mf = 0.0;
+
+    if (mixed_precision) {
+      const unsigned int n_iterations =
+          solve_mixed_precision(solver_control.tolerance());
+
+      copy_locally_owned(delta_owned, delta_mf, locally_owned_dofs);
+      delta_owned.compress(VectorOperation::insert);
+      constraints.distribute(delta_owned);
+
+      return n_iterations;
+    }
+
+    const TimedPreconditioner<DiagonalMatrix<
+        LinearAlgebra::distributed::Vector<double>>>
+        timed_preconditioner(*jacobian_operator.get_matrix_diagonal_inverse(),
+                             metric(step_metrics.preconditioner_apply));
+    solve_krylov(solver_control, jacobian_operator, delta_mf, residual_mf,
+                 timed_preconditioner);
+
+    copy_locally_owned(delta_owned, delta_mf, locally_owned_dofs);
+    delta_owned.compress(VectorOperation::insert);
+    constraints.distribute(delta_owned);
+
+    return solver_control.last_step();
+  }
+
+  // The preconditioner built from an earlier Jacobian of the same time step
+  // (or of an earlier one) is still a good approximation of the current one.
+  // A reused Jacobian keeps its preconditioner.
+  if (preconditioner_outdated ||
+      (preconditioner_rebuild_interval == 0 && jacobian_assembly))
+    setup_preconditioner();
+
+  const TimedPreconditioner<TrilinosWrappers::PreconditionBase>
+      timed_preconditioner(*preconditioner,
+                           metric(step_metrics.preconditioner_apply));
+  solve_krylov(solver_control, jacobian_matrix, delta_owned, residual_vector,
+               timed_preconditioner);
+  constraints.distribute(delta_owned);
+
+  return solver_control.last_step();
+}
+
+unsigned int FisherKolmogorov3D::solve_mixed_precision(const double tolerance) {
+  // Float resolves about seven digits, so each inner solve reduces the
+  // defect by at most 1e-4, and the outer loop recovers the accuracy
+  // requested by the Newton iteration. With a loose tolerance, e.g. in the
+  // inexact Newton method, a single inner solve is enough.
+  const double inner_reduction = std::max(linear_tolerance_factor, 1e-4);
+
+  LinearAlgebra::distributed::Vector<double> defect(residual_mf);
+  LinearAlgebra::distributed::Vector<double> correction(residual_mf);
+
+  const TimedPreconditioner<DiagonalMatrix<
+      LinearAlgebra::distributed::Vector<float>>>
+      timed_preconditioner(
+          *jacobian_operator_float.get_matrix_diagonal_inverse(),
+          metric(step_metrics.preconditioner_apply));
+
+  unsigned int n_iterations = 0;
+  double defect_norm = defect.l2_norm();
+
+  while (defect_norm > tolerance && n_iterations < max_cg_iterations) {
+    residual_mf_float.copy_locally_owned_data_from(defect);
+    delta_mf_float = 0.0f;
+
+    SolverControl inner_control(max_cg_iterations - n_iterations,
+                                inner_reduction * residual_mf_float.l2_norm());
+    solve_krylov(inner_control, jacobian_operator_float, delta_mf_float,
+                 residual_mf_float, timed_preconditioner);
+    n_iterations += inner_control.last_step();
+
+    // Defect of the updated correction, in double precision.
+    correction.copy_locally_owned_data_from(delta_mf_float);
+    delta_mf += correction;
+
+    jacobian_operator.vmult(correction, delta_mf);
+    defect.equ(1.0, residual_mf);
+    defect -= correction;
+    defect_norm = defect.l2_norm();
+  }
+
+  AssertThrow(defect_norm <= tolerance,
+              SolverControl::NoConvergence(n_iterations, defect_norm));
+
+  return n_iterations;
+}
+
+bool FisherKolmogorov3D::reuse_jacobian(const unsigned int n_iter,
+                                        const double residual_norm_old,
+                                        const double residual_norm_older) {
+  // Modified Newton: the Jacobian of the previous iteration is kept as long
+  // as the residual keeps dropping fast enough with it.
+  // The cached Jacobian is also kept, across time steps too, while it is
+  // close enough to the one at the current iterate.
+  const bool reuse = (jacobian_reuse && n_iter >= 2 &&
+                      residual_norm_old <
+                          jacobian_reuse_threshold * residual_norm_older) ||
+                     operator_cache_valid();
+
+  record_operator_cache(reuse);
+
+  // The Jacobian about to be assembled is linearized at the current iterate.
+  if (!reuse) {
+    linearization_point = solution_owned;
+    linearization_mass_coefficient = time_coefficients[0] / deltat;
+    linearization_valid = true;
+  }
+
+  return reuse;
+}
+
+double FisherKolmogorov3D::linear_tolerance(
+    const unsigned int n_iter, const double residual_norm,
+    const double residual_norm_old) const {
+  if (!inexact_newton)
+    return cg_tolerance_factor;
+
+  // Eisenstat-Walker forcing term (choice 2), with the safeguard that
+  // prevents it from dropping too quickly, and bounded from below so that
+  // the last iteration is not solved beyond the Newton tolerance.
+  double eta = max_forcing_term;
+  if (n_iter > 0) {
+    const double eta_old = linear_tolerance_factor;
+    eta = forcing_gamma *
+          std::pow(residual_norm / residual_norm_old, forcing_exponent);
+
+    const double eta_safeguard =
+        forcing_gamma * std::pow(eta_old, forcing_exponent);
+    if (eta_safeguard > 0.1)
+      eta = std::max(eta, eta_safeguard);
+  }
+
+  eta = std::max(eta, 0.5 * newton_tolerance / residual_norm);
+  return std::min(std::max(eta, cg_tolerance_factor), max_forcing_term);
+}
+
+void FisherKolmogorov3D::update_newton_iterate() {
+  // The overlapped assembly exchanges the ghost values by itself.
+  if (!communication_overlap)
+    update_ghosted_solution();
+}
+
+void FisherKolmogorov3D::predict_solution() {
+  if (predictor_type == "Reaction") {
+    advance_reaction(deltat);
+    return;
+  } else if (predictor_type == "Linear" || predictor_type == "Quadratic") {
+    // Lagrange extrapolation through the latest accepted solutions. Until
+    // enough steps are available the order is reduced.
+    const unsigned int n_points =
+        std::min<unsigned int>(predictor_type == "Linear" ? 2 : 3,
+                               solution_history.size());
+    if (n_points < 2)
+      return;
+
+    solution_owned = 0.0;
+    for (unsigned int k = 0; k < n_points; ++k) {
+      double weight = 1.0;
+      for (unsigned int m = 0; m < n_points; ++m)
+        if (m != k)
+          weight *= (time - time_history[m]) /
+                    (time_history[k] - time_history[m]);
+
+      solution_owned.add(weight, solution_history[k]);
+    }
+  } else
+    return;
+
+  update_ghosted_solution();
+}
+
+void FisherKolmogorov3D::advance_reaction(const double step) {
+  const double growth = std::exp(alpha * step);
+
+  for (const auto i : locally_owned_dofs) {
+    const double u = solution(i);
+    solution_owned(i) = u * growth / (1.0 - u + u * growth);
+  }
+  solution_owned.compress(VectorOperation::insert);
+  constraints.distribute(solution_owned);
+
+  update_ghosted_solution();
+}
+
+void FisherKolmogorov3D::solve_linear_step() {
+  TimerOutput::Scope t(timer, "Solve linear step");
+
+  newton_iterations_step = 0;
+  cg_iterations_step = 0;
+  linear_tolerance_factor = cg_tolerance_factor;
+
+  // Strang splitting: half a reaction step, a diffusion step, and another
+  // half reaction step.
+  if (time_integrator == "Strang")
+    advance_reaction(0.5 * deltat);
+
+  // The new solution u satisfies
+  //   (M / deltat + theta K) u = (M / deltat - (1 - theta) K) u* + M f(u*),
+  // with u* the current solution and the reaction f(u) = alpha u (1 - u)
+  // only present in the IMEX integrator. It is solved for the increment
+  // u - u*, whose right-hand side is -K u* + M f(u*).
+  stiffness_matrix.vmult(residual_vector, solution_owned);
+  residual_vector *= -1.0;
+
+  if (time_integrator == "IMEX") {
+    TrilinosWrappers::MPI::Vector reaction(locally_owned_dofs, MPI_COMM_WORLD);
+    for (const auto i : locally_owned_dofs) {
+      const double u = solution(i);
+      reaction(i) = alpha * u * (1 - u);
+    }
+    reaction.compress(VectorOperation::insert);
+
+    // The reaction is interpolated at the nodes and integrated with the
+    // (lumped) mass matrix.
+    if (lumped_reaction) {
+      reaction.scale(lumped_mass);
+      residual_vector += reaction;
+    } else {
+      TrilinosWrappers::MPI::Vector mass_reaction(locally_owned_dofs,
+                                                  MPI_COMM_WORLD);
+      mass_matrix.vmult(mass_reaction, reaction);
+      residual_vector += mass_reaction;
+    }
+  }
+
+  // The system matrix and its preconditioner only change with the time
+  // step.
+  record_operator_cache(!preconditioner_outdated);
+
+  delta_owned = 0.0;
+  solve_linear_system();
+
+  solution_owned += delta_owned;
+  update_ghosted_solution();
+
+  if (time_integrator == "Strang")
+    advance_reaction(0.5 * deltat);
+}
+
+void FisherKolmogorov3D::update_time_step(const double new_deltat) {
+  if (new_deltat == deltat)
+    return;
+
+  deltat = new_deltat;
+
+  update_time_operators();
+}
+
+void FisherKolmogorov3D::update_time_scheme(
+    const unsigned int /*time_step*/) {
+  std::array<double, 3> coefficients = {{1.0, -1.0, 0.0}};
+
+  // Variable-step BDF2, with the ratio omega of the current time step to
+  // the previous one. The first step is a backward Euler step; refinement,
+  // rebalancing and restarts keep the history, so that they do not change
+  // the scheme.
+  if (time_integrator == "Newton" && time_scheme == "BDF2" &&
+      time_history.size() >= 2) {
+    const double omega = deltat / (time_history[0] - time_history[1]);
+
+    coefficients[0] = (1.0 + 2.0 * omega) / (1.0 + omega);
+    coefficients[1] = -(1.0 + omega);
+    coefficients[2] = omega * omega / (1.0 + omega);
+
+    solution_older = solution_history[1];
+  }
+
+  // The mass term only changes with a0.
+  const bool mass_changed = coefficients[0] != time_coefficients[0];
+  time_coefficients = coefficients;
+
+  if (matrix_free)
+    jacobian_operator.set_time_scheme(time_coefficients, newton_theta());
+  if (mixed_precision)
+    jacobian_operator_float.set_time_scheme(time_coefficients,
+                                            newton_theta());
+  if (mass_changed)
+    update_time_operators();
+}
+
+void FisherKolmogorov3D::update_time_operators() {
+  // The mass term a0 M / deltat is part of the cached operators.
+  if (split_assembly)
+    assemble_constant_matrix();
+  if (matrix_free)
+    jacobian_operator.set_time_step(deltat);
+  if (mixed_precision)
+    jacobian_operator_float.set_time_step(deltat);
+  if (time_integrator != "Newton")
+    update_linear_system_matrix();
+
+  preconditioner_outdated = true;
+}
+
+void FisherKolmogorov3D::adapt_time_step() {
+  const double cg_per_newton =
+      static_cast<double>(cg_iterations_step) /
+      std::max(newton_iterations_step, 1u);
+
+  double new_deltat = deltat;
+
+  // Hard steps (many Newton or CG iterations) shrink the time step, easy
+  // steps let it grow again.
+  if (time_integrator == "Newton") {
+    if (newton_iterations_step > target_newton_iterations ||
+        cg_per_newton > target_cg_iterations)
+      new_deltat = 0.5 * deltat;
+    else if (newton_iterations_step < target_newton_iterations)
+      new_deltat = deltat_growth_factor * deltat;
+  } else {
+    // The linear integrators take a single CG solve per step, whose matrix
+    // M / deltat + theta K has a condition number growing like deltat, so
+    // that the CG iterations grow like sqrt(deltat). The time step only
+    // grows if the next step is expected to stay within the target.
+    if (cg_iterations_step > target_cg_iterations)
+      new_deltat = 0.5 * deltat;
+    else if (cg_iterations_step * std::sqrt(deltat_growth_factor) <=
+             target_cg_iterations)
+      new_deltat = deltat_growth_factor * deltat;
+  }
+
+  new_deltat = std::min(std::max(new_deltat, deltat_min), deltat_max);
+
+  if (new_deltat != deltat)
+    pcout << "  deltat = " << deltat << " -> " << new_deltat << std::endl;
+
+  update_time_step(new_deltat);
+}
+
+void FisherKolmogorov3D::refine_mesh() {
+  TimerOutput::Scope t(timer, "Refine mesh");
+
+  auto &distributed_mesh =
+      dynamic_cast<parallel::distributed::Triangulation<dim> &>(*mesh);
+
+  // Error indicator of each cell, from the jumps of the gradient across the
+  // faces (Kelly) or from the gradient itself, weighted with the cell size
+  // (Gradient).
+  Vector<float> estimated_error(mesh->n_active_cells());
+  if (refinement_indicator == "Gradient") {
+    DerivativeApproximation::approximate_gradient(*mapping, dof_handler,
+                                                  solution, estimated_error);
+
+    for (const auto &cell : mesh->active_cell_iterators())
+      if (cell->is_locally_owned())
+        estimated_error[cell->active_cell_index()] *=
+            std::pow(cell->diameter(), 1.0 + dim / 2.0);
+  } else
+    KellyErrorEstimator<dim>::estimate(
+        *mapping, dof_handler, QGauss<dim - 1>(r + 1),
+        std::map<types::boundary_id, const Function<dim> *>(), solution,
+        estimated_error);
+
+  parallel::distributed::GridRefinement::refine_and_coarsen_fixed_fraction(
+      distributed_mesh, estimated_error, refine_fraction, coarsen_fraction);
+
+  if (mesh->n_levels() > max_refinement_level)
+    for (const auto &cell :
+         mesh->active_cell_iterators_on_level(max_refinement_level))
+      cell->clear_refine_flag();
+
+  // All the stored time levels move to the new mesh, so that BDF2 and the
+  // extrapolation predictors go on with their history.
+  parallel::distributed::SolutionTransfer<dim, TrilinosWrappers::MPI::Vector>
+      solution_transfer(dof_handler);
+  const std::vector<TrilinosWrappers::MPI::Vector> levels =
+      history_for_transfer();
+  std::vector<const TrilinosWrappers::MPI::Vector *> levels_in;
+  for (const auto &level : levels)
+    levels_in.push_back(&level);
+
+  // The refined mesh is repartitioned with the current cell weights.
+  prepare_cell_weights();
+
+  mesh->prepare_coarsening_and_refinement();
+  solution_transfer.prepare_for_coarsening_and_refinement(levels_in);
+  mesh->execute_coarsening_and_refinement();
+
+  ++n_refinements;
+
+  setup_system();
+
+  std::vector<TrilinosWrappers::MPI::Vector> transferred(
+      levels.size(),
+      TrilinosWrappers::MPI::Vector(locally_owned_dofs, MPI_COMM_WORLD));
+  std::vector<TrilinosWrappers::MPI::Vector *> transferred_out;
+  for (auto &level : transferred)
+    transferred_out.push_back(&level);
+  solution_transfer.interpolate(transferred_out);
+
+  restore_history(transferred);
+
+  // The HDF5 series continues on a new mesh file.
+  hdf5_mesh_written = false;
+
+  pcout << "  Refined mesh: " << mesh->n_global_active_cells()
+        << " elements, " << dof_handler.n_dofs() << " DoFs" << std::endl;
+}
+
+std::vector<TrilinosWrappers::MPI::Vector>
+FisherKolmogorov3D::history_for_transfer() const {
+  // The current solution, then the older accepted ones, with their ghost
+  // values as SolutionTransfer needs them.
+  std::vector<TrilinosWrappers::MPI::Vector> levels(
+      std::max<std::size_t>(solution_history.size(), 1), solution);
+  for (unsigned int k = 1; k < levels.size(); ++k)
+    levels[k] = solution_history[k];
+  return levels;
+}
+
+void FisherKolmogorov3D::restore_history(
+    std::vector<TrilinosWrappers::MPI::Vector> &levels) {
+  for (auto &level : levels)
+    constraints.distribute(level);
+
+  solution_owned = levels[0];
+  update_ghosted_solution();
+
+  // The times of the levels do not change.
+  solution_history.assign(levels.begin(), levels.end());
+  time_history.resize(levels.size(), time);
+  if (levels.size() > 1)
+    solution_old = levels[1];
+}
+
+void FisherKolmogorov3D::prepare_cell_weights() {
+  if (rebalance_interval > 0 && rebalance_cost == "Measured") {
+    double local_cost = 0.0;
+    for (const auto &cell : mesh->active_cell_iterators())
+      if (cell->is_locally_owned())
+        local_cost += cell_cost[cell->active_cell_index()];
+
+    mean_cell_cost = Utilities::MPI::sum(local_cost, MPI_COMM_WORLD) /
+                     mesh->n_global_active_cells();
+  } else if (rebalance_interval > 0 || active_region_assembly)
+    update_active_region();
+}
+
+unsigned int FisherKolmogorov3D::cell_weight(
+    const Triangulation<dim>::cell_iterator &cell,
+    const Triangulation<dim>::CellStatus status) const {
+  // Weight of an active cell of the current mesh.
+  const auto active_weight = [this](const Triangulation<dim>::cell_iterator &c) {
+    if (rebalance_interval > 0 && rebalance_cost == "Measured") {
+      // About a tenth of the weight stays uniform, for the work that goes
+      // with the DoFs rather than with the assembly.
+      if (mean_cell_cost <= 0.0)
+        return 0u;
+      return static_cast<unsigned int>(
+          std::round(9000.0 * cell_cost[c->active_cell_index()] /
+                     mean_cell_cost));
+    }
+
+    return active_cell_ids.count(c->id()) > 0 ? 1000 * (active_cell_weight - 1)
+                                              : 0u;
+  };
+
+  // A coarsened cell is as expensive as the most expensive of its children.
+  if (status == Triangulation<dim>::CELL_COARSEN) {
+    unsigned int weight = 0;
+    for (unsigned int c = 0; c < cell->n_children(); ++c)
+      weight = std::max(weight, active_weight(cell->child(c)));
+    return weight;
+  }
+
+  return active_weight(cell);
+}
+
+void FisherKolmogorov3D::rebalance_mesh() {
+  TimerOutput::Scope t(timer, "Rebalance mesh");
+
+  auto &distributed_mesh =
+      dynamic_cast<parallel::distributed::Triangulation<dim> &>(*mesh);
+
+  prepare_cell_weights();
+
+  // Load of the process with the current weights.
+  double local_load = 0.0;
+  for (const auto &cell : mesh->active_cell_iterators())
+    if (cell->is_locally_owned())
+      local_load += 1000 + cell_weight(cell, Triangulation<dim>::CELL_PERSIST);
+
+  const Utilities::MPI::MinMaxAvg load =
+      Utilities::MPI::min_max_avg(local_load, MPI_COMM_WORLD);
+  const double imbalance = load.avg > 0.0 ? load.max / load.avg : 1.0;
+
+  pcout << "  Load imbalance (max/average) = " << std::fixed
+        << std::setprecision(2) << imbalance;
+
+  if (imbalance <= rebalance_threshold) {
+    pcout << ", keeping the partitioning" << std::endl;
+
+    // The next check measures the cells over a new window.
+    std::fill(cell_cost.begin(), cell_cost.end(), 0.0);
+    return;
+  }
+
+  pcout << ", repartitioning" << std::endl;
+
+  // All the stored time levels move to the new owners of their DoFs.
+  parallel::distributed::SolutionTransfer<dim, TrilinosWrappers::MPI::Vector>
+      solution_transfer(dof_handler);
+  const std::vector<TrilinosWrappers::MPI::Vector> levels =
+      history_for_transfer();
+  std::vector<const TrilinosWrappers::MPI::Vector *> levels_in;
+  for (const auto &level : levels)
+    levels_in.push_back(&level);
+  solution_transfer.prepare_for_coarsening_and_refinement(levels_in);
+
+  distributed_mesh.repartition();
+  ++n_rebalances;
+
+  setup_system();
+
+  std::vector<TrilinosWrappers::MPI::Vector> transferred(
+      levels.size(),
+      TrilinosWrappers::MPI::Vector(locally_owned_dofs, MPI_COMM_WORLD));
+  std::vector<TrilinosWrappers::MPI::Vector *> transferred_out;
+  for (auto &level : transferred)
+    transferred_out.push_back(&level);
+  solution_transfer.interpolate(transferred_out);
+
+  restore_history(transferred);
+
+  // The HDF5 series continues on a new mesh file.
+  hdf5_mesh_written = false;
+
+  pcout << "  Repartitioned mesh: max/average cells per process = "
+        << Utilities::MPI::max(mesh->n_locally_owned_active_cells(),
+                               MPI_COMM_WORLD) /
+               (mesh->n_global_active_cells() / static_cast<double>(mpi_size))
+        << std::endl;
+}
+
+bool FisherKolmogorov3D::output_scheduled(const unsigned int &time_step) {
+  // The final solution is always written.
+  if (time >= T - 0.5 * deltat)
+    return true;
+
+  if (output_time_interval > 0.0) {
+    if (time < next_output_time - 0.5 * deltat)
+      return false;
+
+    while (next_output_time < time + 0.5 * deltat)
+      next_output_time += output_time_interval;
+    return true;
+  }
+
+  return time_step % output_interval == 0;
+}
+
+void FisherKolmogorov3D::update_ghosted_solution() {
+  ScopedMetric m(metric(step_metrics.ghost_exchange));
+  solution = solution_owned;
+}
+
+void FisherKolmogorov3D::write_step_metrics(const unsigned int time_step,
+                                            const double step_deltat) {
+  const double step_time = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - step_start)
+                               .count();
+
+  // The phases are reported for the slowest process, the whole step and the
+  // assembly also with their spread across the processes.
+  const std::vector<double> local_times = {step_metrics.assembly,
+                                           step_metrics.preconditioner_setup,
+                                           step_metrics.preconditioner_apply,
+                                           step_metrics.linear_solve,
+                                           step_metrics.ghost_exchange,
+                                           step_metrics.output,
+                                           step_time};
+  const std::vector<Utilities::MPI::MinMaxAvg> times =
+      Utilities::MPI::min_max_avg(local_times, MPI_COMM_WORLD);
+
+  const std::vector<std::pair<std::string, double>> fields = {
+      {"time", time},
+      {"deltat", step_deltat},
+      {"newton_iterations", static_cast<double>(newton_iterations_step)},
+      {"cg_iterations", static_cast<double>(cg_iterations_step)},
+      {"assembly", times[0].max},
+      {"preconditioner_setup", times[1].max},
+      {"preconditioner_apply", times[2].max},
+      {"linear_solve", times[3].max},
+      {"ghost_exchange", times[4].max},
+      {"output", times[5].max},
+      {"assembly_min", times[0].min},
+      {"assembly_max", times[0].max},
+      {"assembly_avg", times[0].avg},
+      {"step_min", times[6].min},
+      {"step_max", times[6].max},
+      {"step_avg", times[6].avg}};
+
+  if (mpi_rank == 0) {
+    if (metrics_format == "JSON") {
+      metrics_stream << "{\"run\": \"" << output_name
+                     << "\", \"step\": " << time_step;
+      for (const auto &[name, value] : fields)
+        metrics_stream << ", \"" << name << "\": " << value;
+      metrics_stream << "}";
+    } else {
+      metrics_stream << output_name << "," << time_step;
+      for (const auto &field : fields)
+        metrics_stream << "," << field.second;
+    }
+
+    // Flushed at every step, so that the file can be followed during the
+    // run.
+    metrics_stream << std::endl;
+  }
+
+  step_metrics = StepMetrics();
+  step_start = std::chrono::steady_clock::now();
+}
+
+void FisherKolmogorov3D::output(const unsigned int &time_step) {
+  TimerOutput::Scope t(timer, "Writing");
+  ScopedMetric m(metric(step_metrics.output));
+
+  // The previous write must be over before a new one is started.
+  wait_for_output();
+
+  auto data_out = std::make_shared<DataOut<dim>>();
+  data_out->add_data_vector(dof_handler, solution, "u");
+
+  if (write_partitioning) {
+    // The partitioning is computed again only when the mesh changes.
+    if (partitioning.size() != mesh->n_active_cells()) {
+      std::vector<unsigned int> partition_int(mesh->n_active_cells());
+      GridTools::get_subdomain_association(*mesh, partition_int);
+      partitioning.reinit(partition_int.size());
+      std::copy(partition_int.begin(), partition_int.end(),
+                partitioning.begin());
+    }
+    data_out->add_data_vector(partitioning, "partitioning");
+  }
+
+  // The patches hold a copy of the data: from here on, the solution can be
+  // overwritten by the next time step.
+  data_out->build_patches();
+
+  // HDF5 output is collective, so it is always written synchronously.
+  if (output_format == "HDF5") {
+    output_hdf5(*data_out, time_step);
+    return;
+  }
+
+  if (!asynchronous_output) {
+    data_out->write_vtu_with_pvtu_record("./", output_name, time_step,
+                                         MPI_COMM_WORLD, 3);
+    return;
+  }
+
+  // The background thread must not call MPI, so that it can run alongside
+  // the communication of the next Newton solve: each process writes its own
+  // piece, and the file names are computed here. They are those of
+  // write_vtu_with_pvtu_record, so that both modes write the same files.
+  const std::string basename =
+      output_name + "_" + Utilities::int_to_string(time_step, 3);
+  const unsigned int rank_digits = Utilities::needed_digits(mpi_size - 1);
+
+  std::vector<std::string> piece_names;
+  if (mpi_rank == 0)
+    for (unsigned int i = 0; i < mpi_size; ++i)
+      piece_names.push_back(basename + "." +
+                            Utilities::int_to_string(i, rank_digits) + ".vtu");
+
+  const std::string piece_name =
+      basename + "." + Utilities::int_to_string(mpi_rank, rank_digits) +
+      ".vtu";
+
+  output_task = std::async(std::launch::async, [data_out, basename,
+                                                piece_name, piece_names]() {
+    std::ofstream piece_file(piece_name);
+    data_out->write_vtu(piece_file);
+
+    if (!piece_names.empty()) {
+      std::ofstream record_file(basename + ".pvtu");
+      data_out->write_pvtu_record(record_file, piece_names);
+    }
+  });
+}
+
+void FisherKolmogorov3D::output_hdf5(DataOut<dim> &data_out,
+                                     const unsigned int &time_step) {
+#ifdef DEAL_II_WITH_HDF5
+  // Each refinement of the mesh starts a new mesh file.
+  const std::string mesh_file_name_h5 =
+      n_refinements == 0 ? output_name + "_mesh.h5"
+                         : output_name + "_mesh_" +
+                               Utilities::int_to_string(n_refinements) + ".h5";
+  const std::string solution_file_name_h5 =
+      output_name + "_" + Utilities::int_to_string(time_step, 3) + ".h5";
+
+  // Merge the duplicated vertices of neighboring patches.
+  DataOutBase::DataOutFilter data_filter(
+      DataOutBase::DataOutFilterFlags(true, true));
+  data_out.write_filtered_data(data_filter);
+
+  // The mesh is written once (per refinement) and referenced by all the time
+  // steps.
+  data_out.write_hdf5_parallel(data_filter, !hdf5_mesh_written,
+                               mesh_file_name_h5, solution_file_name_h5,
+                               MPI_COMM_WORLD);
+  hdf5_mesh_written = true;
+
+  xdmf_entries.push_back(
+      data_out.create_xdmf_entry(data_filter, mesh_file_name_h5,
+                                 solution_file_name_h5, time, MPI_COMM_WORLD));
+
+  // Rewrite the (small) XDMF index, so that the series can be opened while
+  // the simulation is running.
+  data_out.write_xdmf_file(xdmf_entries, output_name + ".xdmf",
+                           MPI_COMM_WORLD);
+#else
+  (void)data_out;
+  (void)time_step;
+  AssertThrow(false, ExcMessage("HDF5 output requires deal.II to be "
+                                "configured with HDF5 support."));
+#endif
+}
+
+void FisherKolmogorov3D::wait_for_output() {
+  if (output_task.valid())
+    output_task.get();
+}
+
+// Checkpoints are written in generations, one directory per checkpointed
+// time step. A generation holds one binary piece per process, listing the
+// owned cells by CellId together with the values of the current and previous
+// solution on their DoFs, and an index of the coarse cells of each piece.
+// CellIds do not depend on the partitioning, so a checkpoint can be read back
+// by any number of processes, each of them reading only the pieces that hold
+// some of its cells. The info file, written by rank 0 once all the pieces
+// are complete, names the current generation: its rename is the only step
+// that changes the checkpoint, so an interrupted write leaves the previous
+// generation in use. The older generations are removed afterwards.
+void FisherKolmogorov3D::write_checkpoint(const unsigned int &time_step) {
+  TimerOutput::Scope t(timer, "Checkpoint");
+
+  const std::filesystem::path directory(checkpoint_directory);
+  const std::string generation =
+      "step-" + Utilities::int_to_string(time_step, 6);
+
+  // A generation of the same step can only be left over by an interrupted
+  // run, possibly with a different number of processes.
+  if (mpi_rank == 0) {
+    std::filesystem::remove_all(directory / generation);
+    std::filesystem::create_directories(directory / generation);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  const std::string piece_name =
+      "solution." + Utilities::int_to_string(mpi_rank, 4) + ".bin";
+
+  std::vector<types::coarse_cell_id> coarse_cells;
+  bool piece_written;
+  {
+    std::ofstream piece((directory / generation / piece_name).string(),
+                        std::ios::binary);
+
+    const std::uint64_t n_cells = mesh->n_locally_owned_active_cells();
+    const std::uint32_t header[2] = {time_step, dofs_per_cell};
+    piece.write(reinterpret_cast<const char *>(header), sizeof(header));
+    piece.write(reinterpret_cast<const char *>(&n_cells), sizeof(n_cells));
+
+    // The three time levels kept by the history: u_n, u_{n-1} and u_{n-2}
+    // (repeated if the run has not taken as many steps yet).
+    TrilinosWrappers::MPI::Vector solution_older_ghosted(
+        locally_owned_dofs, locally_relevant_dofs, MPI_COMM_WORLD);
+    solution_older_ghosted =
+        solution_history.size() > 2 ? solution_history[2] : solution_owned;
+
+    Vector<double> values(dofs_per_cell);
+    Vector<double> values_old(dofs_per_cell);
+    Vector<double> values_older(dofs_per_cell);
+
+    for (const auto &cell : dof_handler.active_cell_iterators()) {
+      if (!cell->is_locally_owned())
+        continue;
+
+      const auto id = cell->id().to_binary<dim>();
+      cell->get_dof_values(solution, values);
+      cell->get_dof_values(solution_old, values_old);
+      cell->get_dof_values(solution_older_ghosted, values_older);
+
+      piece.write(reinterpret_cast<const char *>(&id), sizeof(id));
+      piece.write(reinterpret_cast<const char *>(values.data()),
+                  dofs_per_cell * sizeof(double));
+      piece.write(reinterpret_cast<const char *>(values_old.data()),
+                  dofs_per_cell * sizeof(double));
+      piece.write(reinterpret_cast<const char *>(values_older.data()),
+                  dofs_per_cell * sizeof(double));
+
+      coarse_cells.push_back(cell->id().get_coarse_cell_id());
+    }
+
+    piece.close();
+    piece_written = !piece.fail();
+  }
+
+  // Every process stops here if any piece is incomplete, and the previous
+  // generation stays the current one.
+  AssertThrow(Utilities::MPI::min(piece_written ? 1u : 0u, MPI_COMM_WORLD) ==
+                  1,
+              ExcMessage("Could not write the checkpoint pieces of n = " +
+                         std::to_string(time_step) + "."));
+
+  std::sort(coarse_cells.begin(), coarse_cells.end());
+  coarse_cells.erase(std::unique(coarse_cells.begin(), coarse_cells.end()),
+                     coarse_cells.end());
+  const std::vector<std::vector<types::coarse_cell_id>> piece_coarse_cells =
+      Utilities::MPI::gather(MPI_COMM_WORLD, coarse_cells, 0);
+
+  bool committed = true;
+  if (mpi_rank == 0) {
+    // The coarse cells of each piece, so that a reader can tell which pieces
+    // hold its cells without opening them.
+    {
+      std::ofstream index((directory / generation / "index.bin").string(),
+                          std::ios::binary);
+      const std::uint64_t n_pieces = piece_coarse_cells.size();
+      index.write(reinterpret_cast<const char *>(&n_pieces), sizeof(n_pieces));
+      for (const auto &cells : piece_coarse_cells) {
+        const std::uint64_t n_cells = cells.size();
+        index.write(reinterpret_cast<const char *>(&n_cells), sizeof(n_cells));
+        index.write(reinterpret_cast<const char *>(cells.data()),
+                    cells.size() * sizeof(types::coarse_cell_id));
+      }
+      index.close();
+      committed = !index.fail();
+    }
+
+    if (committed) {
+      std::ofstream info((directory / "checkpoint.info.tmp").string());
+      // The times of the previous solutions let BDF2 and the predictors
+      // resume with the history of the uninterrupted run.
+      const double time_old =
+          time_history.size() > 1 ? time_history[1] : time;
+      const double time_older =
+          time_history.size() > 2 ? time_history[2] : time_old;
+      info << std::setprecision(17) << time_step << " " << time << " "
+           << deltat << " " << mpi_size << " " << dofs_per_cell << " "
+           << time_old << " " << time_older << " " << generation
+           << std::endl;
+      info.close();
+      committed = !info.fail();
+    }
+
+    if (committed) {
+      std::filesystem::rename(directory / "checkpoint.info.tmp",
+                              directory / "checkpoint.info");
+
+      // Only the new generation is referenced from now on.
+      for (const auto &entry : std::filesystem::directory_iterator(directory))
+        if (entry.is_directory() &&
+            entry.path().filename().string().rfind("step-", 0) == 0 &&
+            entry.path().filename() != generation)
+          std::filesystem::remove_all(entry.path());
+    }
+  }
+
+  AssertThrow(Utilities::MPI::min(committed ? 1u : 0u, MPI_COMM_WORLD) == 1,
+              ExcMessage("Could not write the checkpoint info of n = " +
+                         std::to_string(time_step) + "."));
+
+  pcout << "  Checkpoint written at n = " << time_step << std::endl;
+}
+
+unsigned int FisherKolmogorov3D::read_checkpoint() {
+  TimerOutput::Scope t(timer, "Checkpoint");
+
+  const std::filesystem::path directory(checkpoint_directory);
+
+  unsigned int time_step;
+  double checkpoint_deltat;
+  unsigned int n_pieces;
+  unsigned int checkpoint_dofs_per_cell;
+  double time_old;
+  double time_older;
+  std::string generation;
+  {
+    std::ifstream info((directory / "checkpoint.info").string());
+    AssertThrow(info, ExcMessage("No checkpoint found in " +
+                                 checkpoint_directory));
+    info >> time_step >> time >> checkpoint_deltat >> n_pieces >>
+        checkpoint_dofs_per_cell >> time_old >> time_older >> generation;
+    AssertThrow(info, ExcMessage("Incomplete checkpoint info file in " +
+                                 checkpoint_directory));
+  }
+
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+  AssertThrow(checkpoint_dofs_per_cell == dofs_per_cell,
+              ExcMessage("The checkpoint was written with a different "
+                         "polynomial degree."));
+  // An adaptive run resumes with the time step chosen for the next step.
+  if (adaptive_time_stepping)
+    update_time_step(checkpoint_deltat);
+  else if (std::abs(checkpoint_deltat - deltat) > 1e-12 * deltat)
+    pcout << "  Warning: the checkpoint was written with deltat = "
+          << checkpoint_deltat << std::endl;
+
+  // Locally owned cells, looked up by their partition-independent id.
+  std::map<CellId, DoFHandler<dim>::active_cell_iterator> owned_cells;
+  std::vector<types::coarse_cell_id> owned_coarse_cells;
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    if (cell->is_locally_owned()) {
+      owned_cells.emplace(cell->id(), cell);
+      owned_coarse_cells.push_back(cell->id().get_coarse_cell_id());
+    }
+  std::sort(owned_coarse_cells.begin(), owned_coarse_cells.end());
+
+  // The pieces holding some of the owned cells, from the index of the
+  // generation.
+  std::vector<unsigned int> pieces;
+  {
+    std::ifstream index((directory / generation / "index.bin").string(),
+                        std::ios::binary);
+    AssertThrow(index, ExcMessage("Missing checkpoint index of " +
+                                  generation));
+
+    std::uint64_t n_indexed_pieces;
+    index.read(reinterpret_cast<char *>(&n_indexed_pieces),
+               sizeof(n_indexed_pieces));
+    AssertThrow(index && n_indexed_pieces == n_pieces,
+                ExcMessage("The checkpoint index of " + generation +
+                           " does not match the info file."));
+
+    std::vector<types::coarse_cell_id> cells;
+    for (unsigned int p = 0; p < n_pieces; ++p) {
+      std::uint64_t n_cells;
+      index.read(reinterpret_cast<char *>(&n_cells), sizeof(n_cells));
+      cells.resize(n_cells);
+      index.read(reinterpret_cast<char *>(cells.data()),
+                 n_cells * sizeof(types::coarse_cell_id));
+      AssertThrow(index, ExcMessage("Truncated checkpoint index of " +
+                                    generation));
+
+      if (std::any_of(cells.begin(), cells.end(), [&](const auto id) {
+            return std::binary_search(owned_coarse_cells.begin(),
+                                      owned_coarse_cells.end(), id);
+          }))
+        pieces.push_back(p);
+    }
+  }
+
+  std::vector<types::global_dof_index> dof_indices(dofs_per_cell);
+  std::vector<double> values(3 * dofs_per_cell);
+
+  TrilinosWrappers::MPI::Vector solution_old_owned(locally_owned_dofs,
+                                                   MPI_COMM_WORLD);
+  TrilinosWrappers::MPI::Vector solution_older_owned(locally_owned_dofs,
+                                                     MPI_COMM_WORLD);
+
+  for (const unsigned int p : pieces) {
+    const std::string piece_name =
+        "solution." + Utilities::int_to_string(p, 4) + ".bin";
+    std::ifstream piece((directory / generation / piece_name).string(),
+                        std::ios::binary);
+    AssertThrow(piece, ExcMessage("Missing checkpoint piece " + piece_name));
+
+    std::uint32_t header[2];
+    std::uint64_t n_cells;
+    piece.read(reinterpret_cast<char *>(header), sizeof(header));
+    piece.read(reinterpret_cast<char *>(&n_cells), sizeof(n_cells));
+    AssertThrow(header[0] == time_step,
+                ExcMessage("Checkpoint piece " + piece_name +
+                           " belongs to a different time step."));
+
+    for (std::uint64_t c = 0; c < n_cells; ++c) {
+      CellId::binary_type id;
+      piece.read(reinterpret_cast<char *>(&id), sizeof(id));
+      piece.read(reinterpret_cast<char *>(values.data()),
+                 values.size() * sizeof(double));
+
+      const auto it = owned_cells.find(CellId(id));
+      if (it == owned_cells.end())
+        continue;
+
+      it->second->get_dof_indices(dof_indices);
+      for (unsigned int i = 0; i < dofs_per_cell; ++i)
+        if (locally_owned_dofs.is_element(dof_indices[i])) {
+          solution_owned(dof_indices[i]) = values[i];
+          solution_old_owned(dof_indices[i]) = values[dofs_per_cell + i];
+          solution_older_owned(dof_indices[i]) =
+              values[2 * dofs_per_cell + i];
+        }
+    }
+  }
+
+  solution_owned.compress(VectorOperation::insert);
+  solution_old_owned.compress(VectorOperation::insert);
+  solution_older_owned.compress(VectorOperation::insert);
+
+  update_ghosted_solution();
+  solution_old = solution_old_owned;
+
+  // All the time levels are history: BDF2 and the extrapolation predictors
+  // use them exactly as the uninterrupted run would. A level is only there
+  // if the run had taken the step.
+  solution_history.assign(1, solution_owned);
+  time_history.assign(1, time);
+  if (time_old < time) {
+    solution_history.push_back(solution_old_owned);
+    time_history.push_back(time_old);
+
+    if (time_older < time_old) {
+      solution_history.push_back(solution_older_owned);
+      time_history.push_back(time_older);
+    }
+  }
+
+  return time_step;
+}
+
+void FisherKolmogorov3D::solve() {
+  TimerOutput::Scope t(timer, "Time loop (solve)");
+
+  FisherKolmogorov::solve();
+}
+
+unsigned int FisherKolmogorov3D::start_run() {
+  unsigned int time_step = 0;
+
+  // Every run starts from the same state, so that the runs of an ensemble
+  // do not depend on each other.
+  update_time_step(deltat_initial);
+  jacobian_assemblies_total = 0;
+  operator_cache_hits = 0;
+  operator_cache_misses = 0;
+  linearization_valid = false;
+  hdf5_mesh_written = false;
+  xdmf_entries.clear();
+  snapshots.clear();
+  std::fill(cell_cost.begin(), cell_cost.end(), 0.0);
+
+  // The metrics file is shared by all the runs of the object (e.g. the
+  // members of an ensemble), told apart by their output name.
+  if (!metrics_file.empty() && mpi_rank == 0 && !metrics_stream.is_open()) {
+    metrics_stream.open(metrics_file);
+    AssertThrow(metrics_stream.is_open(),
+                ExcMessage("Could not open the metrics file " + metrics_file));
+    metrics_stream << std::setprecision(6);
+
+    if (metrics_format == "CSV")
+      metrics_stream << "run,step,time,deltat,newton_iterations,"
+                        "cg_iterations,assembly,preconditioner_setup,"
+                        "preconditioner_apply,linear_solve,ghost_exchange,"
+                        "output,assembly_min,assembly_max,assembly_avg,"
+                        "step_min,step_max,step_avg"
+                     << std::endl;
+  }
+
+  if (restart) {
+    // Resume from the last checkpoint.
+    pcout << "Restarting from the last checkpoint" << std::endl;
+
+    // Checkpoints store the solution cell by cell on the mesh read from the
+    // mesh file.
+    AssertThrow(!adaptive_refinement,
+                ExcMessage("Restart is not supported with adaptive "
+                           "refinement."));
+
+    time_step = read_checkpoint();
+
+    pcout << "  n = " << time_step << ", t = " << time << std::endl;
+    pcout << "-----------------------------------------------" << std::endl;
+  } else {
+    // Apply the initial condition.
+    pcout << "Applying the initial condition" << std::endl;
+
+    initial_condition(solution_owned);
+    update_ghosted_solution();
+
+    solution_history.assign(1, solution_owned);
+    time_history.assign(1, time);
+
+    // Refine the mesh around the initial front before the first step.
+    for (unsigned int cycle = 0;
+         adaptive_refinement && cycle < initial_refinement_cycles; ++cycle) {
+      refine_mesh();
+
+      initial_condition(solution_owned);
+      constraints.distribute(solution_owned);
+      update_ghosted_solution();
+    }
+
+    // Output the initial solution.
+    output(0);
+    pcout << "-----------------------------------------------" << std::endl;
+
+    if (snapshot_interval > 0)
+      snapshots.push_back(solution_owned);
+
+    solution_history.assign(1, solution_owned);
+    time_history.assign(1, time);
+  }
+
+  step_metrics = StepMetrics();
+  step_start = std::chrono::steady_clock::now();
+
+  // First output time after the current one.
+  next_output_time = output_time_interval;
+  while (output_time_interval > 0.0 &&
+         next_output_time < time + 0.5 * deltat)
+    next_output_time += output_time_interval;
+
+  return time_step;
+}
+
+bool FisherKolmogorov3D::final_time_reached() const {
+  // With a fixed time step the loop stops at the last multiple of deltat,
+  // while the adaptive one ends exactly at T.
+  return adaptive_time_stepping ? time >= T * (1.0 - 1e-12)
+                                : time >= T - 0.5 * deltat;
+}
+
+void FisherKolmogorov3D::begin_time_step(const unsigned int time_step) {
+  if (adaptive_time_stepping && time + deltat > T)
+    update_time_step(T - time);
+
+  // The matrix of the linear integrators only changes with the time step.
+  if (time_integrator == "Newton" && preconditioner_rebuild_interval > 0 &&
+      (time_step - 1) % preconditioner_rebuild_interval == 0)
+    preconditioner_outdated = true;
+
+  // Starting point of the step, restored if the step is rejected.
+  if (adaptive_time_stepping)
+    solution_start = solution_owned;
+}
+
+bool FisherKolmogorov3D::solve_time_step() {
+  if (time_integrator != "Newton") {
+    solve_linear_step();
+    return true;
+  }
+
+  // Start Newton's method from a prediction of the new solution rather than
+  // from the old one.
+  predict_solution();
+
+  TimerOutput::Scope t(timer, "Solve nonlinear (Newton)");
+
+  const bool converged = solve_newton();
+
+  // The overlapped assembly exchanged the ghost values of the iterates it
+  // assembled, but not those of the last one.
+  if (communication_overlap)
+    update_ghosted_solution();
+
+  return converged;
+}
+
+bool FisherKolmogorov3D::accept_time_step(const bool converged) {
+  // A step on which Newton fails is repeated with half the time step.
+  if (adaptive_time_stepping && !converged && deltat > deltat_min) {
+    pcout << "  Newton did not converge, rejecting the step" << std::endl;
+
+    solution_owned = solution_start;
+    update_ghosted_solution();
+
+    update_time_step(std::max(0.5 * deltat, deltat_min));
+    return false;
+  }
+
+  // The smallest time step did not help either: the solution would not
+  // be that of the requested tolerance.
+  AssertThrow(!adaptive_time_stepping || converged,
+              ExcMessage("Newton did not converge at t = " +
+                         std::to_string(time) +
+                         " with the minimum time step " +
+                         std::to_string(deltat_min) + "."));
+
+  return FisherKolmogorov::accept_time_step(converged);
+}
+
+void FisherKolmogorov3D::end_time_step(const unsigned int time_step) {
+  const double step_deltat = deltat;
+
+  if (active_region_assembly)
+    pcout << "  Active cells = " << std::fixed << std::setprecision(1)
+          << 100.0 * active_cell_fraction << "% (max/average per process "
+          << std::setprecision(2) << active_cell_imbalance << ")"
+          << std::endl;
+
+  if (time_integrator == "Newton")
+    pcout << "  Newton iterations = " << newton_iterations_step
+          << " (total " << newton_iterations_total << "), CG iterations = "
+          << cg_iterations_step << " (total " << cg_iterations_total << ")"
+          << std::endl;
+  else
+    pcout << "  CG iterations = " << cg_iterations_step << " (total "
+          << cg_iterations_total << ")" << std::endl;
+
+  // Keep the latest accepted solutions for the extrapolation predictors.
+  solution_history.push_front(solution_owned);
+  time_history.push_front(time);
+  if (solution_history.size() > 3) {
+    solution_history.pop_back();
+    time_history.pop_back();
+  }
+
+  if (snapshot_interval > 0 && time_step % snapshot_interval == 0)
+    snapshots.push_back(solution_owned);
+
+  if (output_scheduled(time_step))
+    output(time_step);
+
+  // The next time step is chosen before the checkpoint, which stores it, so
+  // that a restarted run takes the same steps as the uninterrupted one.
+  if (adaptive_time_stepping)
+    adapt_time_step();
+
+  if (checkpoint_interval > 0 && time_step % checkpoint_interval == 0)
+    write_checkpoint(time_step);
+
+  if (adaptive_refinement && time_step % refinement_interval == 0)
+    refine_mesh();
+  else if (rebalance_interval > 0 && time_step % rebalance_interval == 0)
+    rebalance_mesh();
+
+  if (!metrics_file.empty())
+    write_step_metrics(time_step, step_deltat);
+}
+
+void FisherKolmogorov3D::end_run(const unsigned int n_time_steps) {
+  wait_for_output();
+
+  time_steps_total = n_time_steps;
+
+  // Totals to compare runs with and without the predictor.
+  pcout << "Total Newton iterations = " << newton_iterations_total
+        << " ("
+        << static_cast<double>(newton_iterations_total) /
+               std::max(n_time_steps, 1u)
+        << " per step), total CG iterations = " << cg_iterations_total
+        << ", Jacobian assemblies = " << jacobian_assemblies_total
+        << std::endl;
+  pcout << "Operator cache hits = " << operator_cache_hits
+        << ", misses = " << operator_cache_misses << std::endl;
+  if (matrix_free)
+    pcout << "Matrix-free memory = " << matrix_free_memory() << " MB"
+          << std::endl;
+}
+
+double FisherKolmogorov3D::matrix_free_memory() const {
+  if (!matrix_free)
+    return 0.0;
+
+  std::size_t memory = matrix_free_data->memory_consumption() +
+                       jacobian_operator.memory_consumption();
+  if (mixed_precision)
+    memory += matrix_free_data_float->memory_consumption() +
+              jacobian_operator_float.memory_consumption();
+
+  return Utilities::MPI::sum(static_cast<double>(memory), MPI_COMM_WORLD) /
+         (1024.0 * 1024.0);
+}
@@ -1,55 +1,89 @@
 #ifndef HEAT_NON_LINEAR_HPP
 #define HEAT_NON_LINEAR_HPP
 
+#include "CellKernel.hpp"
 #include "DiffusionTensor.hpp"
+#include "FisherKolmogorov.hpp"
+#include "HexahedralMesh.hpp"
+#include "JacobianOperator.hpp"
+#include "SolverPipeCG.hpp"
+#include "StepMetrics.hpp"
 
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/symmetric_tensor.h>
 #include <deal.II/base/timer.h>
+#include <deal.II/base/work_stream.h>
 
 #include <deal.II/distributed/fully_distributed_tria.h>
+#include <deal.II/distributed/grid_refinement.h>
+#include <deal.II/distributed/solution_transfer.h>
+#include <deal.II/distributed/tria.h>
 
 #include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_renumbering.h>
 #include <deal.II/dofs/dof_tools.h>
 
+#include <deal.II/fe/fe_q.h>
 #include <deal.II/fe/fe_simplex_p.h>
 #include <deal.II/fe/fe_system.h>
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/fe/fe_values_extractors.h>
 #include <deal.II/fe/mapping_fe.h>
+#include <deal.II/fe/mapping_q.h>
 
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/grid/grid_in.h>
 #include <deal.II/grid/grid_tools.h>
+#include <deal.II/grid/tria_description.h>
 
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/la_parallel_vector.h>
 #include <deal.II/lac/solver_cg.h>
 #include <deal.II/lac/trilinos_precondition.h>
 #include <deal.II/lac/trilinos_sparse_matrix.h>
 
 #include <deal.II/base/tensor_function.h>
+#include <deal.II/matrix_free/matrix_free.h>
 #include <deal.II/numerics/data_out.h>
+#include <deal.II/numerics/derivative_approximation.h>
+#include <deal.II/numerics/error_estimator.h>
 #include <deal.II/numerics/matrix_tools.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <map>
+#include <numeric>
+#include <set>
 
 using namespace dealii;
 
-// Class representing the non-linear diffusion problem.
-class FisherKolmogorov3D {
+// Trilinos linear algebra on the mesh of the brain solver, which is fully
+// distributed for tetrahedra and distributed for hexahedra.
+// FisherKolmogorov3D::create_triangulation() picks it once the element type
+// is known.
+struct BrainLinearAlgebra : TrilinosLinearAlgebra {
+  template <int dim> using Triangulation = parallel::TriangulationBase<dim>;
+};
+
+// Class representing the non-linear diffusion problem. The Newton
+// iterations, the linear solves and the time loop are those of the
+// FisherKolmogorov template, extended through its hooks.
+class FisherKolmogorov3D : public FisherKolmogorov<3, BrainLinearAlgebra> {
 public:
   // Physical dimension (1D, 2D, 3D)
   static constexpr unsigned int dim = 3;
 
-  // Function for the forcing term.
-  class ForcingTerm : public Function<dim> {
-  public:
-    virtual double value(const Point<dim> & /*p*/,
-                         const unsigned int /*component*/ = 0) const override {
-      return 0.0;
-    }
-  };
-
   // Function for initial conditions.
   class FunctionU0 : public Function<dim> {
   public:
@@ -72,11 +106,45 @@ public:
                      const unsigned int &r_, const double &T_,
                      const double &deltat_, ConditionalOStream &pcout_in,
                      TimerOutput &timer_in)
-      : mpi_size(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD)),
+      : FisherKolmogorov(r_, T_, deltat_, alpha_, pcout_in),
+        mpi_size(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD)),
         mpi_rank(Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)),
-        d(d_), alpha(alpha_), T(T_), mesh_file_name(mesh_file_name_), 
-        r(r_), deltat(deltat_), pcout(pcout_in), timer(timer_in),
-        mesh(MPI_COMM_WORLD) {}
+        d(&d_), mesh_file_name(mesh_file_name_), deltat_initial(deltat_),
+        timer(timer_in) {}
+
+  // Set how the mesh is read and partitioned, and whether the partitioned
+  // mesh is cached in binary form for later runs.
+  void set_mesh_parameters(const std::string &loading,
+                           const unsigned int group_size,
+                           const bool cache, const std::string &cache_directory);
+
+  // Select the element type: the tetrahedra of the mesh file, or hexahedra
+  // obtained by splitting each tetrahedron into four.
+  void set_element_type(const std::string &element_type_);
+
+  // Set the adaptive refinement of the (hexahedral) mesh, which refines and
+  // coarsens the mesh every interval time steps to follow the front.
+  void set_refinement_parameters(const bool adaptive, const unsigned int interval,
+                                 const std::string &indicator,
+                                 const double refine_fraction_,
+                                 const double coarsen_fraction_,
+                                 const unsigned int max_level,
+                                 const unsigned int initial_cycles);
+
+  // Set the dynamic rebalancing of the (hexahedral) mesh: every interval
+  // time steps, the cells are weighted by their cost, measured during the
+  // assembly or modeled from the distance to the front, and the mesh is
+  // repartitioned if the load of a process exceeds the average by more than
+  // the threshold factor.
+  void set_rebalancing_parameters(const unsigned int interval,
+                                  const std::string &cost,
+                                  const double threshold);
+
+  // Set the partitioner of the mesh, the weight of the cells in the seed
+  // region of the initial condition, and the renumbering of the DoFs.
+  void set_partitioning_parameters(const std::string &partitioner_,
+                                   const unsigned int seed_weight,
+                                   const std::string &renumbering);
 
   // Set the parameters for the Newton method and CG solver.
   void set_solver_parameters(const unsigned int max_newton_iter,
@@ -84,24 +152,417 @@ public:
                              const unsigned int max_cg_iter,
                              const double cg_tol_factor);
 
-  // Initialization.
-  void setup();
+  // Select the Krylov solver of the linear systems: CG, or pipelined CG,
+  // which overlaps its single reduction per iteration with the
+  // preconditioner and the matrix-vector product.
+  void set_linear_solver(const std::string &linear_solver_);
+
+  // Select whether the Jacobian is assembled or applied matrix-free, and
+  // whether the matrix-free linear solves run in mixed precision: the
+  // corrections are computed with a single-precision operator and CG, inside
+  // a defect correction loop in double precision.
+  void set_matrix_free(const bool matrix_free_,
+                       const bool mixed_precision_ = false);
+
+  // Select whether mass and stiffness are assembled once (split assembly) and
+  // whether the reaction mass matrix is lumped.
+  void set_assembly_parameters(const bool split_assembly_,
+                               const bool lumped_reaction_);
+
+  // Set the active-region assembly, which only runs the quadrature loop on
+  // the cells around the front. Cells where u is within tolerance of 0 or 1
+  // reuse their cached cell matrices, halo layers of cells around the front
+  // are kept active, and active cells weigh active_weight times more when
+  // the hexahedral mesh is repartitioned.
+  void set_active_region_parameters(const bool active_region,
+                                    const double tolerance,
+                                    const unsigned int halo,
+                                    const unsigned int active_weight);
+
+  // Overlap the communication of the Newton iterations with the assembly:
+  // the cells whose DoFs are all locally owned and unconstrained are
+  // assembled while the ghost values of the iterate are exchanged and while
+  // the residual is compressed, so that only the cells at the process
+  // boundaries wait for the messages.
+  void set_communication_overlap(const bool overlap);
+
+  // Set the preconditioner for the assembled Jacobian and how often it is
+  // rebuilt.
+  void set_preconditioner_parameters(const std::string &type,
+                                     const unsigned int rebuild_interval,
+                                     const std::string &amg_smoother,
+                                     const unsigned int amg_sweeps,
+                                     const double amg_threshold);
+
+  // Set the relative change of the Jacobian below which the assembled
+  // Jacobian and its preconditioner are reused (0 = only if unchanged).
+  void set_operator_cache(const double threshold);
+
+  // Set how often the solution is written and how.
+  void set_output_parameters(const std::string &format,
+                             const unsigned int interval,
+                             const double time_interval,
+                             const bool write_partitioning_,
+                             const bool asynchronous);
+
+  // Stream per-step metrics (iterations, phase timings, load imbalance) to
+  // a file, as CSV or JSON lines (empty file name = off).
+  void set_metrics_parameters(const std::string &file,
+                              const std::string &format);
+
+  // Store a snapshot of the solution every interval time steps (0 = none),
+  // for the offline stage of the reduced-order model.
+  void set_snapshot_interval(const unsigned int interval);
+
+  // Set the checkpoint frequency and whether the run restarts from the last
+  // checkpoint.
+  void set_checkpoint_parameters(const unsigned int interval,
+                                 const std::string &directory,
+                                 const bool restart_);
+
+  // Set the adaptive time step controller. The time step grows when Newton
+  // and CG converge in fewer iterations than the targets, and shrinks when
+  // they need more.
+  void set_adaptive_time_stepping(const bool adaptive,
+                                  const double min_deltat,
+                                  const double max_deltat,
+                                  const unsigned int target_newton,
+                                  const unsigned int target_cg,
+                                  const double growth_factor);
+
+  // Select how the initial guess of Newton's method is predicted (None,
+  // Linear, Quadratic or Reaction).
+  void set_predictor(const std::string &predictor_type_);
+
+  // Select the time integrator: fully implicit Newton, Strang splitting of
+  // reaction and diffusion, or semi-implicit IMEX. Theta weights the implicit
+  // part of the diffusion in the linear integrators, and of the whole step
+  // in the Newton integrator with the Theta scheme (1 = backward Euler,
+  // 0.5 = Crank-Nicolson). The BDF2 scheme of the Newton integrator ignores
+  // it.
+  void set_time_integrator(const std::string &integrator, const double theta_,
+                           const std::string &time_scheme_ = "Theta");
+
+  // Set the inexact Newton method, whose CG tolerance follows the
+  // Eisenstat-Walker forcing term, and the modified Newton policy, which
+  // keeps the previous Jacobian while the residual drops fast enough.
+  void set_newton_parameters(const bool inexact, const double gamma,
+                             const double exponent, const double max_forcing,
+                             const bool reuse, const double reuse_threshold);
 
-  // Solve the problem.
-  void solve();
+  // Initialization.
+  void setup() override;
+
+  // Change the diffusion tensor and the reaction coefficient between two
+  // runs of an ensemble. After setup(), only the terms that depend on them
+  // are recomputed: the mesh, the DoFs and the sparsity pattern are kept.
+  void set_problem_coefficients(DiffusionTensor<dim> &d_, const double alpha_);
+
+  // Same, but the problem shares the ownership of the tensor, which then
+  // lives as long as it is in use, also past the scope of the caller.
+  void set_problem_coefficients(const std::shared_ptr<DiffusionTensor<dim>> &d_,
+                                const double alpha_);
+
+  // Set the base name of the output files (default "output").
+  void set_output_name(const std::string &name);
+
+  // Solve the problem. It can be called again, e.g. after changing the
+  // coefficients, and starts over from the initial condition.
+  void solve() override;
+
+  // Statistics of the last run, for the benchmarks.
+  types::global_dof_index n_dofs() const { return dof_handler.n_dofs(); }
+  unsigned int n_time_steps() const { return time_steps_total; }
+  unsigned int n_newton_iterations() const { return newton_iterations_total; }
+  unsigned int n_cg_iterations() const { return cg_iterations_total; }
+  unsigned int n_operator_cache_hits() const { return operator_cache_hits; }
+  unsigned int n_operator_cache_misses() const {
+    return operator_cache_misses;
+  }
+
+  // Memory of the matrix-free data and operators, in MB summed over the
+  // processes (0 with the assembled Jacobian). Collective.
+  double matrix_free_memory() const;
+
+  // Snapshots of the solution stored by the last run.
+  const std::vector<TrilinosWrappers::MPI::Vector> &get_snapshots() const {
+    return snapshots;
+  }
+
+  // Assemble the mass matrix and the stiffness matrix of the current
+  // diffusion tensor, for the reduced-order model. Requires the
+  // matrix-based Jacobian, whose sparsity pattern they share.
+  void assemble_mass_and_stiffness(TrilinosWrappers::SparseMatrix &mass,
+                                   TrilinosWrappers::SparseMatrix &stiffness);
+
+  // Interpolate the initial condition on the locally owned DoFs.
+  void interpolate_initial_condition(TrilinosWrappers::MPI::Vector &dst) const;
 
 protected:
-  // Assemble the tangent problem.
-  void assemble_system();
+  // Fully distributed triangulation for tetrahedra, p4est one for
+  // hexahedra.
+  std::unique_ptr<TriangulationType> create_triangulation() const override;
+
+  // Read, partition and distribute the mesh.
+  void create_mesh() override;
+
+  // Create the finite element space, the quadrature formula and the
+  // mapping of the element type.
+  void create_finite_element() override;
+
+  // Diffusion tensor at a point.
+  SymmetricTensor<2, dim> diffusion_tensor(const Point<dim> &p) const override;
+
+  // Interpolate the initial condition into the locally owned solution.
+  void initial_condition(TrilinosWrappers::MPI::Vector &u_0_owned) override;
+
+  // Read the mesh file into a serial triangulation.
+  void read_serial_mesh(Triangulation<dim> &mesh_serial) const;
+
+  // Build the distributed hexahedral mesh from the mesh file.
+  void create_hexahedral_mesh();
+
+  // Throw if the solver options set so far cannot be used together.
+  void check_solver_options() const;
+
+  // Distribute the DoFs and initialize the constraints, the cached
+  // coefficients and the linear system on the current mesh.
+  void setup_system();
+
+  // Refine and coarsen the mesh according to the error indicator of the
+  // current solution, and transfer the solution to the new mesh.
+  void refine_mesh();
+
+  // The current solution and the older ones of the history, with ghost
+  // values, to be moved to a new mesh or partitioning.
+  std::vector<TrilinosWrappers::MPI::Vector> history_for_transfer() const;
+
+  // Take the transferred levels of history_for_transfer() as the current
+  // solution and history.
+  void restore_history(std::vector<TrilinosWrappers::MPI::Vector> &levels);
+
+  // Repartition the mesh with the cell weights, if the load is unbalanced,
+  // and transfer the solution to the new owners.
+  void rebalance_mesh();
+
+  // Update what the cell weights depend on: the front, or the mean measured
+  // cost of a cell.
+  void prepare_cell_weights();
+
+  // Weight of a cell for p4est, on top of the default 1000.
+  unsigned int
+  cell_weight(const Triangulation<dim>::cell_iterator &cell,
+              const Triangulation<dim>::CellStatus status) const;
+
+  // Assign the cells of the serial mesh to n_partitions subdomains.
+  void partition_mesh(Triangulation<dim> &mesh_serial,
+                      const unsigned int n_partitions) const;
+
+  // Renumber the locally owned DoFs to improve the locality of the matrix.
+  void renumber_dofs();
+
+  // Evaluate the diffusion tensor at the quadrature points of all locally
+  // owned cells and store it in the cache.
+  void cache_diffusion_tensor();
+
+  // Assemble the solution-independent part a0 M / deltat + theta K of the
+  // Jacobian and the lumped mass vector.
+  void assemble_constant_matrix();
+
+  // Store the mass and stiffness matrices of each locally owned cell, used
+  // by the active-region assembly on the cells away from the front.
+  void cache_cell_matrices();
+
+  // Find the cells around the front, whose contributions are assembled in
+  // full, and report how many they are.
+  void update_active_region();
+
+  // Per-thread scratch data for the cell assembly.
+  struct AssemblyScratchData {
+    AssemblyScratchData(const FiniteElement<dim> &fe,
+                        const Quadrature<dim> &quadrature,
+                        const UpdateFlags update_flags);
+
+    AssemblyScratchData(const AssemblyScratchData &scratch_data);
+
+    FEValues<dim> fe_values;
+
+    // Value and gradient of the solution on current cell.
+    std::vector<double> solution_loc;
+    std::vector<Tensor<1, dim>> solution_gradient_loc;
+
+    // Value of the solution at previous timestep (un) on current cell.
+    std::vector<double> solution_old_loc;
+
+    // Gradient of the solution at the previous timestep (explicit part of
+    // the theta method) and value at the one before (BDF2).
+    std::vector<Tensor<1, dim>> solution_old_gradient_loc;
+    std::vector<double> solution_older_loc;
+
+    // Nodal values of the solution at the three time levels, and of the
+    // terms multiplied by the cached mass and stiffness matrices, on the
+    // cells away from the front.
+    Vector<double> dof_values;
+    Vector<double> dof_values_old;
+    Vector<double> dof_values_older;
+    Vector<double> mass_values;
+    Vector<double> stiffness_values;
+  };
+
+  // Cell contributions copied into the global system.
+  struct AssemblyCopyData {
+    FullMatrix<double> cell_matrix;
+    Vector<double> cell_residual;
+    std::vector<types::global_dof_index> dof_indices;
+  };
+
+  // Whether the Jacobian needs cell matrix contributions.
+  bool assemble_cell_matrix() const;
+
+  // Assemble the tangent problem. If assemble_jacobian is false, only the
+  // residual is assembled and the current Jacobian is kept.
+  void assemble_system(const bool assemble_jacobian = true) override;
+
+  // Assemble the contributions of a single cell.
+  void local_assemble_system(const DoFHandler<dim>::active_cell_iterator &cell,
+                             AssemblyScratchData &scratch,
+                             AssemblyCopyData &copy_data);
+
+  // Add the contributions of a single cell to the global system.
+  void copy_local_to_global(const AssemblyCopyData &copy_data);
+
+  // Build the preconditioner from the current Jacobian matrix.
+  void setup_preconditioner();
+
+  // Whether the Jacobian assembled (or linearized) last, and its
+  // preconditioner, can be used at the current solution and time step.
+  bool operator_cache_valid() const;
+
+  // Keep the Jacobian while the residual drops fast enough with it
+  // (modified Newton) or while the operator cache is valid; a new Jacobian
+  // becomes the cached one.
+  bool reuse_jacobian(const unsigned int n_iter, const double residual_norm_old,
+                      const double residual_norm_older) override;
+
+  // CG tolerance of the inexact Newton method, from the Eisenstat-Walker
+  // forcing term.
+  double linear_tolerance(const unsigned int n_iter, const double residual_norm,
+                          const double residual_norm_old) const override;
+
+  // Update the ghosted solution, unless the overlapped assembly exchanges
+  // the ghost values by itself.
+  void update_newton_iterate() override;
+
+  // Record a hit or a miss of the operator cache, counted for the summary
+  // at the end of the run and the benchmark file.
+  void record_operator_cache(const bool hit);
+
+  // Sort the locally owned cells into those that need no ghost values and
+  // add only to locally owned entries, and the others.
+  void classify_interior_cells();
+
+  // Solve the tangent problem with the matrix-free or assembled Jacobian
+  // and the selected Krylov solver and preconditioner.
+  unsigned int solve_tangent_problem(SolverControl &solver_control) override;
+
+  // Solve A x = b with the selected Krylov solver.
+  template <typename MatrixType, typename VectorType,
+            typename PreconditionerType>
+  void solve_krylov(SolverControl &solver_control, const MatrixType &A,
+                    VectorType &x, const VectorType &b,
+                    const PreconditionerType &preconditioner) const {
+    if (linear_solver == "PipeCG") {
+      SolverPipeCG<VectorType> solver(solver_control);
+      solver.solve(A, x, b, preconditioner);
+    } else {
+      SolverCG<VectorType> solver(solver_control);
+      solver.solve(A, x, b, preconditioner);
+    }
+  }
+
+  // Solve the matrix-free system for delta_mf by defect correction, with the
+  // corrections computed in single precision. Returns the number of CG
+  // iterations.
+  unsigned int solve_mixed_precision(const double tolerance);
+
+  // Hooks of the time loop: restart or initial refinement, adaptive time
+  // steps with rejection, the linear integrators, and the output,
+  // checkpoints, mesh adaptation and metrics of each accepted step.
+  unsigned int start_run() override;
+  bool final_time_reached() const override;
+  void begin_time_step(const unsigned int time_step) override;
+  bool solve_time_step() override;
+  bool accept_time_step(const bool converged) override;
+  void end_time_step(const unsigned int time_step) override;
+  void end_run(const unsigned int n_time_steps) override;
+
+  // Seed solution_owned with a prediction of the solution at the new time.
+  void predict_solution();
+
+  // Advance the solution with the exact solution of the reaction-only
+  // problem u' = alpha u (1 - u) over the given time, at each node.
+  void advance_reaction(const double step);
+
+  // Assemble the mass and stiffness matrices of the linear integrators.
+  void assemble_linear_operators();
 
-  // Solve the linear system associated to the tangent problem.
-  void solve_linear_system();
+  // Build the system matrix M / deltat + theta K of the linear integrators.
+  void update_linear_system_matrix();
 
-  // Solve the problem for one time step using Newton's method.
-  void solve_newton();
+  // Solve one time step with the Strang or IMEX integrator, with a single
+  // linear solve.
+  void solve_linear_step();
+
+  // Change the time step, updating the terms that depend on it.
+  void update_time_step(const double new_deltat);
+
+  // Compute the coefficients of the time derivative of the current step,
+  // from the times of the previous solutions, and update the terms that
+  // depend on them.
+  void update_time_scheme(const unsigned int time_step) override;
+
+  // Update the cached operators that contain the mass term a0 M / deltat.
+  void update_time_operators();
+
+  // Weight of the implicit part of the Newton step.
+  double newton_theta() const { return time_scheme == "BDF2" ? 1.0 : theta; }
+
+  // Choose the time step for the next step from the convergence history of
+  // the last one.
+  void adapt_time_step();
+
+  // Whether the solution of the current time step has to be written.
+  bool output_scheduled(const unsigned int &time_step);
 
   // Output.
-  void output(const unsigned int &time_step) const;
+  void output(const unsigned int &time_step) override;
+
+  // Copy the locally owned solution into the ghosted one.
+  void update_ghosted_solution();
+
+  // Counter of the per-step metrics, or nullptr if they are off.
+  double *metric(double &counter) {
+    return metrics_file.empty() ? nullptr : &counter;
+  }
+
+  // Append the metrics of the time step, taken with the given step size, to
+  // the metrics file, and reset them.
+  void write_step_metrics(const unsigned int time_step,
+                          const double step_deltat);
+
+  // Append the patches of the current time step to the HDF5/XDMF series.
+  void output_hdf5(DataOut<dim> &data_out, const unsigned int &time_step);
+
+  // Wait for the pending asynchronous write, if any.
+  void wait_for_output();
+
+  // Write the current and previous solutions, the time and the time step as
+  // a new generation of the checkpoint directory, and remove the older ones.
+  void write_checkpoint(const unsigned int &time_step);
+
+  // Read the last checkpoint and return the time step it was written at. The
+  // checkpoint may have been written with a different number of processes.
+  unsigned int read_checkpoint();
 
   // MPI parallel. /////////////////////////////////////////////////////////////
 
@@ -114,87 +575,375 @@ protected:
   // Problem definition. ///////////////////////////////////////////////////////
 
   // d coefficient.
-  DiffusionTensor<dim> &d;
-
-  // alpha coefficient.
-  const double alpha;
+  DiffusionTensor<dim> *d;
 
-  // Forcing term.
-  ForcingTerm forcing_term;
+  // Owner of d, if it was given as a shared pointer.
+  std::shared_ptr<DiffusionTensor<dim>> d_owner;
 
   // Initial conditions.
   FunctionU0 u_0;
 
-  // Current time.
-  double time;
+  // Krylov solver of the linear systems (CG or PipeCG).
+  std::string linear_solver = "CG";
+
+  // Whether the Jacobian is applied matrix-free instead of being assembled.
+  bool matrix_free = false;
+
+  // Whether the matrix-free linear solves use the single-precision operator.
+  bool mixed_precision = false;
+
+  // Whether a0 M / deltat + theta K is assembled once and only the reaction
+  // term is assembled at each Newton iteration.
+  bool split_assembly = false;
+
+  // Whether the reaction term uses the lumped mass matrix.
+  bool lumped_reaction = false;
+
+  // Active-region assembly. ///////////////////////////////////////////////////
+
+  // Whether only the cells around the front are assembled in full.
+  bool active_region_assembly = false;
+
+  // Distance from 0 and 1 below which u is considered constant.
+  double active_region_tolerance = 1e-6;
+
+  // Layers of cells kept active around the front.
+  unsigned int active_region_halo = 1;
+
+  // Partitioner weight of an active cell, relative to an inactive one.
+  unsigned int active_cell_weight = 4;
+
+  // State of each cell, indexed by active_cell_index(): the value (0 or 1)
+  // of u on the cells away from the front, or active_cell_state.
+  static constexpr signed char active_cell_state = -1;
+  std::vector<signed char> cell_state;
+
+  // Active locally owned cells, by CellId, used for the cell weights when
+  // the mesh is repartitioned.
+  std::set<CellId> active_cell_ids;
+
+  // Mass and stiffness matrices of each locally owned cell, stored row by
+  // row at cell_cache_index[active_cell_index()] * dofs_per_cell^2.
+  std::vector<unsigned int> cell_cache_index;
+  std::vector<double> cell_mass_cache;
+  std::vector<double> cell_stiffness_cache;
+
+  // Fraction of active cells, and the largest number of active cells of a
+  // process relative to the average.
+  double active_cell_fraction = 1.0;
+  double active_cell_imbalance = 1.0;
 
-  // Final time.
-  const double T;
+  // Whether the ghost exchange and the compression of the residual overlap
+  // with the assembly of the interior cells.
+  bool communication_overlap = false;
 
-  // Maximum number of Newton iterations.
-  unsigned int max_newton_iterations;
+  // Locally owned cells that only read and write locally owned DoFs, and
+  // the other locally owned cells.
+  std::vector<DoFHandler<dim>::active_cell_iterator> interior_cells;
+  std::vector<DoFHandler<dim>::active_cell_iterator> boundary_cells;
 
-  // Newton tolerance.
-  double newton_tolerance;
+  // Newton iterate and residual of the overlapped assembly, whose ghost
+  // values are exchanged with non-blocking messages.
+  LinearAlgebra::distributed::Vector<double> solution_overlap;
+  LinearAlgebra::distributed::Vector<double> residual_overlap;
 
-  // Max CG iteration
-  unsigned int max_cg_iterations;
+  // Preconditioner type (AMG, SSOR or ILU).
+  std::string preconditioner_type = "SSOR";
 
-  // CG tolerance factor.
-  double cg_tolerance_factor;
+  // Time steps between preconditioner rebuilds (0 = every Newton iteration).
+  unsigned int preconditioner_rebuild_interval = 1;
+
+  // AMG smoother type.
+  std::string amg_smoother_type = "Chebyshev";
+
+  // AMG smoother sweeps.
+  unsigned int amg_smoother_sweeps = 2;
+
+  // AMG aggregation threshold.
+  double amg_aggregation_threshold = 1e-4;
+
+  // Inexact Newton. ///////////////////////////////////////////////////////////
+
+  // Whether the CG tolerance follows the Eisenstat-Walker forcing term.
+  bool inexact_newton = false;
+
+  // Parameters of the forcing term eta_k = gamma (r_k / r_{k-1})^exponent.
+  double forcing_gamma = 0.9;
+  double forcing_exponent = 2.0;
+
+  // Largest forcing term, also used at the first Newton iteration.
+  double max_forcing_term = 0.9;
+
+  // Whether the Jacobian and preconditioner are kept between Newton
+  // iterations while the residual drops fast enough (modified Newton).
+  bool jacobian_reuse = false;
+
+  // Largest residual reduction r_k / r_{k-1} for which the Jacobian is kept.
+  double jacobian_reuse_threshold = 0.25;
+
+  // Whether the Jacobian is being assembled in the current assembly pass.
+  bool jacobian_assembly = true;
+
+  // Number of Jacobian assemblies since the beginning of the run.
+  unsigned int jacobian_assemblies_total = 0;
+
+  // Operator cache. ///////////////////////////////////////////////////////////
+
+  // Largest estimated relative change of the Jacobian for which the cached
+  // Jacobian and preconditioner are reused (0 = disabled).
+  double operator_cache_threshold = 0.0;
+
+  // Solution and mass coefficient a0 / deltat at which the cached Jacobian
+  // was assembled.
+  TrilinosWrappers::MPI::Vector linearization_point;
+  double linearization_mass_coefficient = 0.0;
+
+  // Whether the cached Jacobian holds an assembled operator.
+  bool linearization_valid = false;
+
+  // Hits and misses of the operator cache.
+  unsigned int operator_cache_hits = 0;
+  unsigned int operator_cache_misses = 0;
 
   // Discretization. ///////////////////////////////////////////////////////////
 
   // Mesh file name.
   const std::string mesh_file_name;
 
-  // Polynomial degree.
-  const unsigned int r;
+  // How the mesh is read (Serial: every process reads the whole mesh;
+  // Groups: one process per group reads it and sends each process its part).
+  std::string mesh_loading = "Serial";
+
+  // Processes per group in the Groups loading (0 = a single group).
+  unsigned int mesh_group_size = 0;
+
+  // Whether the partitioned mesh is cached in binary form.
+  bool mesh_cache = false;
+
+  // Directory of the cached partitioned mesh.
+  std::string mesh_cache_directory = "mesh-cache";
+
+  // Element type (Tetrahedra or Hexahedra).
+  std::string element_type = "Tetrahedra";
+
+  // Adaptive refinement. //////////////////////////////////////////////////////
+
+  // Whether the mesh is adaptively refined.
+  bool adaptive_refinement = false;
+
+  // Time steps between two refinement cycles.
+  unsigned int refinement_interval = 5;
+
+  // Refinement indicator (Kelly or Gradient).
+  std::string refinement_indicator = "Kelly";
+
+  // Fractions of the estimated error of the cells that are refined and
+  // coarsened.
+  double refine_fraction = 0.3;
+  double coarsen_fraction = 0.3;
+
+  // Maximum refinement level of the cells.
+  unsigned int max_refinement_level = 2;
+
+  // Refinement cycles applied to the initial condition.
+  unsigned int initial_refinement_cycles = 0;
+
+  // Number of refinement cycles so far.
+  unsigned int n_refinements = 0;
+
+  // Time steps between two rebalancing checks (0 = never).
+  unsigned int rebalance_interval = 0;
+
+  // Cost model of the cells (Front or Measured).
+  std::string rebalance_cost = "Front";
+
+  // Largest load of a process, relative to the average, that is tolerated.
+  double rebalance_threshold = 1.1;
+
+  // Assembly time of each cell since the last rebalancing, indexed by
+  // active_cell_index() (Measured cost).
+  std::vector<double> cell_cost;
+
+  // Average measured cost of a locally owned cell over all the processes.
+  double mean_cell_cost = 0.0;
+
+  // Number of repartitionings so far.
+  unsigned int n_rebalances = 0;
+
+  // Mesh partitioner (METIS, Zoltan or Hilbert).
+  std::string partitioner = "METIS";
+
+  // Partitioner weight of the cells where the initial condition is positive
+  // (1 = all cells weigh the same).
+  unsigned int seed_cell_weight = 1;
+
+  // DoF renumbering (None, Cuthill-McKee or Hilbert).
+  std::string dof_renumbering = "None";
 
-  // Time step.
-  const double deltat;
+  // Time step given to the constructor, restored at the start of each run.
+  const double deltat_initial;
 
-  // Parallel output stream.
-  ConditionalOStream &pcout;
+  // Time integrator (Newton, Strang or IMEX).
+  std::string time_integrator = "Newton";
+
+  // Adaptive time stepping. ///////////////////////////////////////////////////
+
+  // Whether the time step is adapted.
+  bool adaptive_time_stepping = false;
+
+  // Bounds of the time step.
+  double deltat_min;
+  double deltat_max;
+
+  // Newton iterations per time step the controller aims at.
+  unsigned int target_newton_iterations;
+
+  // Average CG iterations per Newton iteration the controller aims at.
+  unsigned int target_cg_iterations;
+
+  // Factor by which the time step grows after an easy step.
+  double deltat_growth_factor;
+
+  // Solution at the start of the current time step, restored if the step is
+  // rejected.
+  TrilinosWrappers::MPI::Vector solution_start;
+
+  // Time steps taken since the beginning of the run.
+  unsigned int time_steps_total = 0;
+
+  // Predictor. ////////////////////////////////////////////////////////////////
+
+  // Predictor of the Newton initial guess.
+  std::string predictor_type = "None";
+
+  // Latest accepted solutions (most recent first) and their times, used by
+  // the extrapolation predictors.
+  std::deque<TrilinosWrappers::MPI::Vector> solution_history;
+  std::deque<double> time_history;
+
+  // Output. //////////////////////////////////////////////////////////////////
+
+  // Output format (VTU or HDF5).
+  std::string output_format = "VTU";
+
+  // Write the solution every output_interval time steps.
+  unsigned int output_interval = 1;
+
+  // If positive, write the solution every output_time_interval time units
+  // instead.
+  double output_time_interval = 0.0;
+
+  // Next time at which the solution is written (time-based cadence).
+  double next_output_time;
+
+  // Whether the partitioning field is written along with the solution.
+  bool write_partitioning = true;
+
+  // Base name of the output files.
+  std::string output_name = "output";
+
+  // Whether files are written by a background thread.
+  bool asynchronous_output = false;
+
+  // Pending asynchronous write.
+  std::future<void> output_task;
+
+  // Whether the mesh has already been written to the HDF5 mesh file.
+  bool hdf5_mesh_written = false;
+
+  // Entries of the XDMF time series.
+  std::vector<XDMFEntry> xdmf_entries;
+
+  // Owner of each cell, computed once for the output.
+  Vector<double> partitioning;
+
+  // Time steps between two snapshots (0 = no snapshots).
+  unsigned int snapshot_interval = 0;
+
+  // Snapshots of the solution, for the reduced-order model.
+  std::vector<TrilinosWrappers::MPI::Vector> snapshots;
+
+  // Per-step metrics. /////////////////////////////////////////////////////////
+
+  // File of the metrics stream (empty = no metrics).
+  std::string metrics_file;
+
+  // Metrics format (CSV or JSON lines).
+  std::string metrics_format = "CSV";
+
+  // Metrics stream, open on the first process.
+  std::ofstream metrics_stream;
+
+  // Phase timings of the current time step, including rejected attempts.
+  StepMetrics step_metrics;
+
+  // Start of the current time step.
+  std::chrono::steady_clock::time_point step_start;
+
+  // Checkpoint/restart. ///////////////////////////////////////////////////////
+
+  // Time steps between checkpoints (0 = no checkpoints).
+  unsigned int checkpoint_interval = 0;
+
+  // Directory holding the checkpoint files.
+  std::string checkpoint_directory = "checkpoint";
+
+  // Whether the run restarts from the last checkpoint.
+  bool restart = false;
 
   // Timer for output.
   TimerOutput &timer;
 
-  // Mesh.
-  parallel::fullydistributed::Triangulation<dim> mesh;
+  // Hanging node constraints (empty unless the mesh is locally refined).
+  AffineConstraints<double> constraints;
+
+  // Time-independent part of the Jacobian, a0 M / deltat + theta K.
+  TrilinosWrappers::SparseMatrix constant_matrix;
 
-  // Finite element space.
-  std::unique_ptr<FiniteElement<dim>> fe;
+  // Row sums of the mass matrix.
+  TrilinosWrappers::MPI::Vector lumped_mass;
 
-  // Quadrature formula.
-  std::unique_ptr<Quadrature<dim>> quadrature;
+  // Mass and stiffness matrices of the linear integrators. Their system
+  // matrix M / deltat + theta K is stored in jacobian_matrix.
+  TrilinosWrappers::SparseMatrix mass_matrix;
+  TrilinosWrappers::SparseMatrix stiffness_matrix;
 
-  // DoF handler.
-  DoFHandler<dim> dof_handler;
+  // Preconditioner for the Jacobian matrix.
+  std::unique_ptr<TrilinosWrappers::PreconditionBase> preconditioner;
 
-  // DoFs owned by current process.
-  IndexSet locally_owned_dofs;
+  // Whether the preconditioner must be rebuilt before the next linear solve.
+  bool preconditioner_outdated = true;
 
-  // DoFs relevant to the current process (including ghost DoFs).
-  IndexSet locally_relevant_dofs;
+  // Linear mapping of the cells.
+  std::unique_ptr<Mapping<dim>> mapping;
 
-  // Jacobian matrix.
-  TrilinosWrappers::SparseMatrix jacobian_matrix;
+  // Matrix-free data (geometry and DoF information stored per cell batch).
+  std::shared_ptr<MatrixFree<dim, double>> matrix_free_data;
 
-  // Residual vector.
-  TrilinosWrappers::MPI::Vector residual_vector;
+  // Matrix-free Jacobian operator.
+  JacobianOperator<dim> jacobian_operator;
 
-  // Increment of the solution between Newton iterations.
-  TrilinosWrappers::MPI::Vector delta_owned;
+  // Single-precision matrix-free data and Jacobian of the mixed-precision
+  // solves.
+  std::shared_ptr<MatrixFree<dim, float>> matrix_free_data_float;
+  JacobianOperator<dim, float> jacobian_operator_float;
 
-  // System solution (without ghost elements).
-  TrilinosWrappers::MPI::Vector solution_owned;
+  // Newton iterate, previous solution, residual and increment in the layout
+  // required by the matrix-free operator.
+  LinearAlgebra::distributed::Vector<double> solution_mf;
+  LinearAlgebra::distributed::Vector<double> solution_old_mf;
+  LinearAlgebra::distributed::Vector<double> solution_older_mf;
+  LinearAlgebra::distributed::Vector<double> residual_mf;
+  LinearAlgebra::distributed::Vector<double> delta_mf;
 
-  // System solution (including ghost elements).
-  TrilinosWrappers::MPI::Vector solution;
+  // Linearization point of the double-precision operator in the
+  // mixed-precision solves.
+  LinearAlgebra::distributed::Vector<double> linearization_mf;
 
-  // System solution at previous time step.
-  TrilinosWrappers::MPI::Vector solution_old;
+  // Newton iterate, defect and correction in single precision.
+  LinearAlgebra::distributed::Vector<float> solution_mf_float;
+  LinearAlgebra::distributed::Vector<float> residual_mf_float;
+  LinearAlgebra::distributed::Vector<float> delta_mf_float;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "FisherKolmogorov3DGPU.hpp"
+
+namespace {
+// Copy the locally owned entries of a host vector to a device vector, or
+// back, through a vector that lives in host memory on both sides.
+template <typename VectorTo, typename VectorFrom>
+void copy_between_memory_spaces(VectorTo &dst, const VectorFrom &src,
+                                const IndexSet &locally_owned_dofs) {
+  LinearAlgebra::ReadWriteVector<double> rw_vector(locally_owned_dofs);
+  rw_vector.import(src, VectorOperation::insert);
+  dst.import(rw_vector, VectorOperation::insert);
+}
+} // namespace
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::set_solver_parameters(
+    const unsigned int max_newton_iter, const double newton_tol,
+    const unsigned int max_cg_iter, const double cg_tol_factor) {
+  max_newton_iterations = max_newton_iter;
+  newton_tolerance = newton_tol;
+  max_cg_iterations = max_cg_iter;
+  cg_tolerance_factor = cg_tol_factor;
+
+  pcout << "-----------------------------------------------" << std::endl;
+  pcout << "Setting solver parameters" << std::endl;
+  pcout << "  Max Newton iterations      = " << max_newton_iterations
+        << std::endl;
+  pcout << "  Newton tolerance           = " << newton_tolerance << std::endl;
+  pcout << "  Max CG iterations          = " << max_cg_iterations << std::endl;
+  pcout << "  CG tolerance factor        = " << cg_tolerance_factor
+        << std::endl;
+  pcout << "-----------------------------------------------" << std::endl;
+}
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::set_output_interval(
+    const unsigned int interval) {
+  output_interval = interval;
+
+  pcout << "  Output interval            = " << output_interval << std::endl;
+}
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::setup() {
+  TimerOutput::Scope t(timer, "Setup");
+
+  // Create the mesh.
+  {
+    pcout << "Initializing the mesh" << std::endl;
+
+    Triangulation<dim> mesh_serial;
+    {
+      GridIn<dim> grid_in;
+      grid_in.attach_triangulation(mesh_serial);
+
+      std::ifstream grid_in_file(mesh_file_name);
+      grid_in.read_msh(grid_in_file);
+    }
+
+    // The CUDA matrix-free kernels only support hexahedra.
+    std::vector<Point<dim>> vertices;
+    std::vector<CellData<dim>> cells;
+    build_hexahedral_mesh(mesh_serial, vertices, cells);
+
+    GridTools::invert_all_negative_measure_cells(vertices, cells);
+    GridTools::consistently_order_cells(cells);
+
+    mesh.create_triangulation(vertices, cells, SubCellData());
+
+    pcout << "  Number of elements = " << mesh.n_global_active_cells()
+          << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Initialize the finite element space.
+  {
+    pcout << "Initializing the finite element space" << std::endl;
+
+    fe = std::make_unique<FE_Q<dim>>(fe_degree);
+
+    pcout << "  Degree                     = " << fe->degree << std::endl;
+    pcout << "  DoFs per cell              = " << fe->dofs_per_cell
+          << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Initialize the DoF handler.
+  {
+    pcout << "Initializing the DoF handler" << std::endl;
+
+    dof_handler.reinit(mesh);
+    dof_handler.distribute_dofs(*fe);
+
+    locally_owned_dofs = dof_handler.locally_owned_dofs();
+    DoFTools::extract_locally_relevant_dofs(dof_handler, locally_relevant_dofs);
+
+    constraints.clear();
+    constraints.reinit(locally_relevant_dofs);
+    constraints.close();
+
+    pcout << "  Number of DoFs = " << dof_handler.n_dofs() << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Initialize the device operator and vectors.
+  {
+    pcout << "Initializing the GPU operator" << std::endl;
+
+    jacobian_operator = std::make_unique<JacobianOperatorGPU<dim, fe_degree>>(
+        dof_handler, constraints, tensor, alpha, deltat);
+
+    jacobian_operator->initialize_dof_vector(residual_vector);
+    jacobian_operator->initialize_dof_vector(delta);
+    jacobian_operator->initialize_dof_vector(solution);
+    jacobian_operator->initialize_dof_vector(solution_old);
+
+    solution_host.reinit(locally_owned_dofs, locally_relevant_dofs,
+                         MPI_COMM_WORLD);
+  }
+}
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::solve_linear_system() {
+  TimerOutput::Scope t(timer, "Solve linear system");
+
+  SolverControl solver_control(max_cg_iterations,
+                               cg_tolerance_factor * residual_vector.l2_norm());
+  SolverCG<VectorType> solver(solver_control);
+
+  // There is no diagonal of the device operator: the mass term dominates
+  // the Jacobian for the time steps of interest, so CG is unpreconditioned.
+  delta = 0.0;
+  solver.solve(*jacobian_operator, delta, residual_vector,
+               PreconditionIdentity());
+
+  cg_iterations_total += solver_control.last_step();
+  pcout << "  " << solver_control.last_step() << " CG iterations" << std::endl;
+}
+
+template <int fe_degree>
+bool FisherKolmogorov3DGPU<fe_degree>::solve_newton() {
+  TimerOutput::Scope t(timer, "Solve nonlinear (Newton)");
+
+  unsigned int n_iter = 0;
+  double residual_norm = newton_tolerance + 1;
+
+  while (n_iter < max_newton_iterations && residual_norm > newton_tolerance) {
+    jacobian_operator->evaluate_residual(residual_vector, solution,
+                                         solution_old);
+    residual_norm = residual_vector.l2_norm();
+
+    pcout << "  Newton iteration " << n_iter << "/" << max_newton_iterations
+          << " - ||r|| = " << std::scientific << std::setprecision(6)
+          << residual_norm << std::flush;
+
+    // We actually solve the system only if the residual is larger than the
+    // tolerance.
+    if (residual_norm > newton_tolerance) {
+      jacobian_operator->evaluate_newton_step(solution);
+      solve_linear_system();
+
+      solution += delta;
+    } else {
+      pcout << " < tolerance" << std::endl;
+    }
+
+    ++n_iter;
+  }
+
+  newton_iterations_total += n_iter;
+
+  return residual_norm <= newton_tolerance;
+}
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::output(const unsigned int &time_step) {
+  TimerOutput::Scope t(timer, "Writing");
+
+  copy_between_memory_spaces(solution_host, solution, locally_owned_dofs);
+  solution_host.update_ghost_values();
+
+  DataOut<dim> data_out;
+  data_out.add_data_vector(dof_handler, solution_host, "u");
+  data_out.build_patches();
+
+  data_out.write_vtu_with_pvtu_record("./", "output", time_step,
+                                      MPI_COMM_WORLD, 3);
+}
+
+template <int fe_degree>
+void FisherKolmogorov3DGPU<fe_degree>::solve() {
+  TimerOutput::Scope t(timer, "Time loop (solve)");
+
+  pcout << "===============================================" << std::endl;
+
+  time = 0.0;
+  unsigned int time_step = 0;
+
+  // Apply the initial condition.
+  {
+    pcout << "Applying the initial condition" << std::endl;
+
+    HostVectorType solution_owned(locally_owned_dofs, MPI_COMM_WORLD);
+    VectorTools::interpolate(dof_handler, u_0, solution_owned);
+    copy_between_memory_spaces(solution, solution_owned, locally_owned_dofs);
+
+    // Output the initial solution.
+    output(0);
+    pcout << "-----------------------------------------------" << std::endl;
+  }
+
+  while (time < T - 0.5 * deltat) {
+    time += deltat;
+    ++time_step;
+
+    // Store the old solution, so that it is available for the residual.
+    solution_old = solution;
+
+    pcout << "n = " << std::setw(3) << time_step << ", t = " << std::setw(5)
+          << std::fixed << time << std::endl;
+
+    // The solution of the previous step is the initial guess of Newton's
+    // method.
+    if (!solve_newton())
+      pcout << "  Warning: Newton did not converge within "
+            << max_newton_iterations << " iterations" << std::endl;
+
+    if (output_interval > 0 && time_step % output_interval == 0)
+      output(time_step);
+
+    pcout << std::endl;
+  }
+
+  pcout << "Total Newton iterations = " << newton_iterations_total
+        << " ("
+        << static_cast<double>(newton_iterations_total) /
+               std::max(time_step, 1u)
+        << " per step), total CG iterations = " << cg_iterations_total
+        << std::endl;
+}
+
+// The CUDA kernels are compiled for each supported polynomial degree.
+template class FisherKolmogorov3DGPU<1>;
+template class FisherKolmogorov3DGPU<2>;
+template class FisherKolmogorov3DGPU<3>;
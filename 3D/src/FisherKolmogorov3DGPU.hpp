@@ -0,0 +1,200 @@
+#ifndef FISHER_KOLMOGOROV_3D_GPU_HPP
+#define FISHER_KOLMOGOROV_3D_GPU_HPP
+
+#include "HexahedralMesh.hpp"
+#include "JacobianOperatorGPU.hpp"
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/timer.h>
+
+#include <deal.II/distributed/tria.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+
+#include <deal.II/fe/fe_q.h>
+
+#include <deal.II/grid/grid_in.h>
+#include <deal.II/grid/grid_tools.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/read_write_vector.h>
+#include <deal.II/lac/solver_cg.h>
+
+#include <deal.II/numerics/data_out.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+using namespace dealii;
+
+// Fisher-Kolmogorov problem solved on the GPU. The mesh file is split into
+// hexahedra as for the "Hexahedra" element type of FisherKolmogorov3D, and
+// Newton's method runs on device vectors: the residual and the Jacobian are
+// applied by the CUDA matrix-free kernels of JacobianOperatorGPU, and the
+// linear systems are solved by CG without ever copying the solution back to
+// the host except for the output.
+//
+// It does not derive from the FisherKolmogorov template: its time loop only
+// takes backward Euler steps of fixed size, with a plain Newton iteration,
+// and main_3D_gpu rejects the options of the CPU solver that need the
+// template hooks (time schemes, predictors, inexact Newton, adaptive steps).
+template <int fe_degree>
+class FisherKolmogorov3DGPU {
+public:
+  // Physical dimension (1D, 2D, 3D)
+  static constexpr unsigned int dim = 3;
+
+  using VectorType =
+      LinearAlgebra::distributed::Vector<double, MemorySpace::CUDA>;
+  using HostVectorType =
+      LinearAlgebra::distributed::Vector<double, MemorySpace::Host>;
+
+  // Function for initial conditions.
+  class FunctionU0 : public Function<dim> {
+  public:
+    virtual double value(const Point<dim> &p,
+                         const unsigned int /*component*/ = 0) const override {
+      if (p[0] < 65 && p[0] > 55 && p[1] < 85 && p[1] > 75 && p[2] < 45 && p[2] > 35) {
+        return 0.9;
+      } else {
+        return 0.0;
+      }
+    }
+  };
+
+  // Constructor.
+  FisherKolmogorov3DGPU(const std::string &mesh_file_name_,
+                        const DiffusionTensorData &tensor_,
+                        const double &alpha_, const double &T_,
+                        const double &deltat_, ConditionalOStream &pcout_in,
+                        TimerOutput &timer_in)
+      : mpi_size(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD)),
+        mpi_rank(Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)),
+        tensor(tensor_), alpha(alpha_), T(T_), mesh_file_name(mesh_file_name_),
+        deltat(deltat_), pcout(pcout_in), timer(timer_in),
+        mesh(MPI_COMM_WORLD) {}
+
+  // Set the parameters for the Newton method and CG solver.
+  void set_solver_parameters(const unsigned int max_newton_iter,
+                             const double newton_tol,
+                             const unsigned int max_cg_iter,
+                             const double cg_tol_factor);
+
+  // Set how often the solution is written.
+  void set_output_interval(const unsigned int interval);
+
+  // Initialization.
+  void setup();
+
+  // Solve the problem.
+  void solve();
+
+protected:
+  // Solve the linear system associated to the tangent problem.
+  void solve_linear_system();
+
+  // Solve the problem for one time step using Newton's method, and return
+  // whether it converged.
+  bool solve_newton();
+
+  // Output.
+  void output(const unsigned int &time_step);
+
+  // MPI parallel. /////////////////////////////////////////////////////////////
+
+  // Number of MPI processes.
+  const unsigned int mpi_size;
+
+  // This MPI process.
+  const unsigned int mpi_rank;
+
+  // Problem definition. ///////////////////////////////////////////////////////
+
+  // Diffusion tensor, evaluated on the device.
+  const DiffusionTensorData tensor;
+
+  // Reaction coefficient.
+  const double alpha;
+
+  // Initial conditions.
+  FunctionU0 u_0;
+
+  // Current time.
+  double time;
+
+  // Final time.
+  const double T;
+
+  // Discretization. ///////////////////////////////////////////////////////////
+
+  // Mesh file name.
+  const std::string mesh_file_name;
+
+  // Time step.
+  const double deltat;
+
+  // Solver parameters.
+  unsigned int max_newton_iterations = 1000;
+  double newton_tolerance = 1e-6;
+  unsigned int max_cg_iterations = 1000;
+  double cg_tolerance_factor = 1e-6;
+
+  // Time steps between outputs (0 = only the initial solution).
+  unsigned int output_interval = 1;
+
+  // Parallel output stream.
+  ConditionalOStream &pcout;
+
+  // Timer for the solver phases.
+  TimerOutput &timer;
+
+  // Mesh.
+  parallel::distributed::Triangulation<dim> mesh;
+
+  // Finite element space.
+  std::unique_ptr<FiniteElement<dim>> fe;
+
+  // DoF handler.
+  DoFHandler<dim> dof_handler;
+
+  // DoFs owned by current process.
+  IndexSet locally_owned_dofs;
+
+  // DoFs relevant to the current process (including ghost DoFs).
+  IndexSet locally_relevant_dofs;
+
+  // Constraints (empty, the mesh is not refined locally).
+  AffineConstraints<double> constraints;
+
+  // Matrix-free Jacobian and residual on the device.
+  std::unique_ptr<JacobianOperatorGPU<dim, fe_degree>> jacobian_operator;
+
+  // Residual vector.
+  VectorType residual_vector;
+
+  // Increment of the solution between Newton iterations.
+  VectorType delta;
+
+  // Solution at the current time step.
+  VectorType solution;
+
+  // Solution at previous time step.
+  VectorType solution_old;
+
+  // Host copy of the solution with ghost values, for the output.
+  HostVectorType solution_host;
+
+  // Iteration counts, for the final summary.
+  unsigned int newton_iterations_total = 0;
+  unsigned int cg_iterations_total = 0;
+};
+
+#endif
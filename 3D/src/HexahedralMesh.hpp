@@ -0,0 +1,81 @@
+#ifndef HEXAHEDRAL_MESH_HPP
+#define HEXAHEDRAL_MESH_HPP
+
+#include <deal.II/grid/reference_cell.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/tria_description.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <vector>
+
+using namespace dealii;
+
+// Split each tetrahedron of the mesh into four hexahedra, one per vertex,
+// with corners at the vertex, the midpoints of its three edges, the centers
+// of its three faces and the center of the tetrahedron. Hexahedra are copied
+// as they are.
+inline void build_hexahedral_mesh(const Triangulation<3> &mesh_serial,
+                                  std::vector<Point<3>> &vertices,
+                                  std::vector<CellData<3>> &cells) {
+  vertices = mesh_serial.get_vertices();
+  cells.clear();
+
+  // New vertices are shared by the neighboring cells: they are identified by
+  // the sorted indices of the vertices they are the center of.
+  std::map<std::vector<unsigned int>, unsigned int> center_vertices;
+  const auto center_vertex = [&](std::vector<unsigned int> indices) {
+    std::sort(indices.begin(), indices.end());
+
+    const auto [it, inserted] =
+        center_vertices.emplace(indices, vertices.size());
+    if (inserted) {
+      Point<3> center;
+      for (const unsigned int i : indices)
+        center += vertices[i];
+      vertices.push_back(center / indices.size());
+    }
+
+    return it->second;
+  };
+
+  for (const auto &cell : mesh_serial.active_cell_iterators()) {
+    CellData<3> hex;
+    hex.material_id = cell->material_id();
+
+    if (cell->reference_cell() == ReferenceCells::Hexahedron) {
+      for (unsigned int v = 0; v < 8; ++v)
+        hex.vertices[v] = cell->vertex_index(v);
+      cells.push_back(hex);
+      continue;
+    }
+
+    std::array<unsigned int, 4> v;
+    for (unsigned int i = 0; i < 4; ++i)
+      v[i] = cell->vertex_index(i);
+
+    const unsigned int c = center_vertex({v[0], v[1], v[2], v[3]});
+
+    // The edges from vertex a to b, e and f are the axes of the hexahedron,
+    // whose vertices are listed in the lexicographic order of deal.II.
+    for (unsigned int i = 0; i < 4; ++i) {
+      const unsigned int a = v[i];
+      const unsigned int b = v[(i + 1) % 4];
+      const unsigned int e = v[(i + 2) % 4];
+      const unsigned int f = v[(i + 3) % 4];
+
+      hex.vertices = {a,
+                      center_vertex({a, b}),
+                      center_vertex({a, e}),
+                      center_vertex({a, b, e}),
+                      center_vertex({a, f}),
+                      center_vertex({a, b, f}),
+                      center_vertex({a, e, f}),
+                      c};
+      cells.push_back(hex);
+    }
+  }
+}
+
+#endif
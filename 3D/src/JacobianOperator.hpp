@@ -0,0 +1,378 @@
+#ifndef JACOBIAN_OPERATOR_HPP
+#define JACOBIAN_OPERATOR_HPP
+
+#include "DiffusionTensor.hpp"
+
+#include <deal.II/base/table.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/matrix_free/tools.h>
+
+#include <array>
+#include <map>
+#include <utility>
+
+using namespace dealii;
+
+// Matrix-free Jacobian of the Fisher-Kolmogorov residual. The action
+//   J(u) v = a0 M v / deltat + theta (K v - alpha (1 - 2 u) M v)
+// of the theta method (a0 = 1) or of BDF2 (theta = 1) is evaluated on the
+// fly at the quadrature points of each cell batch, so that the tangent
+// matrix never has to be stored. The residual itself is evaluated in the
+// same way. On hexahedra, FEEvaluation uses sum factorization, with
+// precompiled kernels for the run-time degree.
+//
+// With Number = float the operator works on single-precision vectors, and
+// serves as the inner solver of the mixed-precision linear solve; the
+// residual is always evaluated in double precision. It then takes its
+// diffusion tensor from the double-precision operator, and the double one
+// computes the reaction term of the defects from the linearization point
+// itself, so that neither table is stored twice.
+template <int dim, typename Number = double>
+class JacobianOperator
+    : public MatrixFreeOperators::Base<
+          dim, LinearAlgebra::distributed::Vector<Number>> {
+public:
+  using VectorType = LinearAlgebra::distributed::Vector<Number>;
+
+  // Simplex elements require the run-time degree version of FEEvaluation.
+  using FECellIntegrator = FEEvaluation<dim, -1, 0, 1, Number>;
+
+  // Set the coefficients of the operator. The diffusion tensor does not
+  // depend on the solution, so it is evaluated once at all quadrature points.
+  void set_coefficients(const DiffusionTensor<dim> &d, const double alpha_,
+                        const double deltat_) {
+    alpha = alpha_;
+    deltat = deltat_;
+
+    const unsigned int n_cells = this->data->n_cell_batches();
+    FECellIntegrator phi(*this->data);
+
+    diffusion_coefficient.reinit(n_cells, phi.n_q_points);
+    for (unsigned int cell = 0; cell < n_cells; ++cell) {
+      phi.reinit(cell);
+
+      for (unsigned int q = 0; q < phi.n_q_points; ++q) {
+        const Point<dim, VectorizedArray<Number>> p_vec =
+            phi.quadrature_point(q);
+
+        for (unsigned int v = 0;
+             v < this->data->n_active_entries_per_cell_batch(cell); ++v) {
+          Point<dim> p;
+          for (unsigned int c = 0; c < dim; ++c)
+            p[c] = p_vec[c][v];
+
+          const Tensor<2, dim> d_loc = d.value(p);
+          for (unsigned int i = 0; i < dim; ++i)
+            for (unsigned int j = 0; j < dim; ++j)
+              diffusion_coefficient(cell, q)[i][j][v] =
+                  static_cast<Number>(d_loc[i][j]);
+        }
+      }
+    }
+  }
+
+  // Copy the coefficients of an operator on the same DoFs and quadrature,
+  // e.g. of the double-precision operator into the single-precision one. The
+  // cell batches of the two may differ, so the cells are matched one by one;
+  // the quadrature points are not needed, and need not be stored.
+  template <typename OtherNumber>
+  void set_coefficients(const JacobianOperator<dim, OtherNumber> &other) {
+    alpha = other.alpha;
+    deltat = other.deltat;
+
+    const MatrixFree<dim, OtherNumber> &other_data =
+        *other.get_matrix_free();
+
+    std::map<std::pair<int, int>, std::pair<unsigned int, unsigned int>>
+        other_lanes;
+    for (unsigned int cell = 0; cell < other_data.n_cell_batches(); ++cell)
+      for (unsigned int v = 0;
+           v < other_data.n_active_entries_per_cell_batch(cell); ++v) {
+        const auto cell_it = other_data.get_cell_iterator(cell, v);
+        other_lanes[{cell_it->level(), cell_it->index()}] = {cell, v};
+      }
+
+    const unsigned int n_cells = this->data->n_cell_batches();
+    const unsigned int n_q_points = other.diffusion_coefficient.size(1);
+
+    diffusion_coefficient.reinit(n_cells, n_q_points);
+    for (unsigned int cell = 0; cell < n_cells; ++cell)
+      for (unsigned int v = 0;
+           v < this->data->n_active_entries_per_cell_batch(cell); ++v) {
+        const auto cell_it = this->data->get_cell_iterator(cell, v);
+        const auto lane = other_lanes.at({cell_it->level(), cell_it->index()});
+
+        for (unsigned int q = 0; q < n_q_points; ++q) {
+          const auto &other_tensor =
+              other.diffusion_coefficient(lane.first, q);
+          for (unsigned int i = 0; i < dim; ++i)
+            for (unsigned int j = 0; j < dim; ++j)
+              diffusion_coefficient(cell, q)[i][j][v] =
+                  static_cast<Number>(other_tensor[i][j][lane.second]);
+        }
+      }
+  }
+
+  // Change the time step of the mass term.
+  void set_time_step(const double deltat_) { deltat = deltat_; }
+
+  // Set the coefficients of the time derivative
+  //   (a0 u + a1 u_old + a2 u_older) / deltat
+  // and the weight theta of the implicit part of the other terms.
+  void set_time_scheme(const std::array<double, 3> &time_coefficients_,
+                       const double theta_) {
+    time_coefficients = time_coefficients_;
+    theta = theta_;
+  }
+
+  // Linearize the reaction term around the current Newton iterate. The
+  // solution vector must have its ghost values up to date.
+  void evaluate_newton_step(const VectorType &solution) {
+    const unsigned int n_cells = this->data->n_cell_batches();
+    FECellIntegrator phi(*this->data);
+
+    const Number reaction_factor = static_cast<Number>(theta * alpha);
+
+    linearization_point = nullptr;
+    reaction_coefficient.reinit(n_cells, phi.n_q_points);
+    for (unsigned int cell = 0; cell < n_cells; ++cell) {
+      phi.reinit(cell);
+      phi.read_dof_values_plain(solution);
+      phi.evaluate(EvaluationFlags::values);
+
+      for (unsigned int q = 0; q < phi.n_q_points; ++q)
+        reaction_coefficient(cell, q) =
+            reaction_factor * (Number(1.0) - Number(2.0) * phi.get_value(q));
+    }
+  }
+
+  // Linearize the reaction term around the given vector, evaluating it
+  // again in each product instead of storing it at the quadrature points.
+  // This costs one more read of a vector per product, and is meant for an
+  // operator that is applied a few times per linearization, such as the
+  // defects of the mixed-precision solve. The vector must stay alive and keep
+  // its ghost values up to date; it has no diagonal.
+  void set_linearization_point(const VectorType &solution) {
+    linearization_point = &solution;
+    reaction_coefficient.reinit(0, 0);
+  }
+
+  // Memory of the operator: the coefficient tables and the diagonal.
+  virtual std::size_t memory_consumption() const override {
+    return MatrixFreeOperators::Base<dim, VectorType>::memory_consumption() +
+           diffusion_coefficient.memory_consumption() +
+           reaction_coefficient.memory_consumption();
+  }
+
+  // Evaluate the residual (with changed sign) of the time step at the given
+  // solution. The old solutions must have their ghost values up to date;
+  // if the solution does not, the cell loop exchanges them while it works on
+  // the cells that do not need them. solution_older is only read by BDF2.
+  void evaluate_residual(VectorType &dst, const VectorType &solution,
+                         const VectorType &solution_old_,
+                         const VectorType &solution_older_) {
+    solution_old = &solution_old_;
+    solution_older = &solution_older_;
+    this->data->cell_loop(&JacobianOperator::local_residual, this, dst,
+                          solution, true);
+    solution_old = nullptr;
+    solution_older = nullptr;
+  }
+
+  // Compute the inverse of the diagonal, used as Jacobi preconditioner.
+  virtual void compute_diagonal() override {
+    Assert(linearization_point == nullptr,
+           ExcMessage("The diagonal needs the stored reaction coefficient."));
+
+    this->inverse_diagonal_entries.reset(new DiagonalMatrix<VectorType>());
+    VectorType &inverse_diagonal = this->inverse_diagonal_entries->get_vector();
+    this->data->initialize_dof_vector(inverse_diagonal);
+
+    MatrixFreeTools::compute_diagonal(*this->data, inverse_diagonal,
+                                      &JacobianOperator::do_cell_integral_local,
+                                      this);
+
+    this->set_constrained_entries_to_one(inverse_diagonal);
+
+    for (unsigned int i = 0; i < inverse_diagonal.locally_owned_size(); ++i)
+      inverse_diagonal.local_element(i) =
+          Number(1.0) / inverse_diagonal.local_element(i);
+  }
+
+private:
+  template <int, typename>
+  friend class JacobianOperator;
+
+  virtual void apply_add(VectorType &dst,
+                         const VectorType &src) const override {
+    this->data->cell_loop(&JacobianOperator::local_apply, this, dst, src);
+  }
+
+  void local_apply(const MatrixFree<dim, Number> &data, VectorType &dst,
+                   const VectorType &src,
+                   const std::pair<unsigned int, unsigned int> &range) const {
+    FECellIntegrator phi(data);
+    FECellIntegrator phi_linearization(data);
+
+    const Number reaction_factor = static_cast<Number>(theta * alpha);
+
+    for (unsigned int cell = range.first; cell < range.second; ++cell) {
+      phi.reinit(cell);
+      phi.read_dof_values(src);
+
+      if (linearization_point) {
+        phi_linearization.reinit(cell);
+        phi_linearization.read_dof_values_plain(*linearization_point);
+        phi_linearization.evaluate(EvaluationFlags::values);
+
+        integrate_cell(phi, [&](const unsigned int q) {
+          return reaction_factor *
+                 (Number(1.0) - Number(2.0) * phi_linearization.get_value(q));
+        });
+      } else
+        do_cell_integral_local(phi);
+
+      phi.distribute_local_to_global(dst);
+    }
+  }
+
+  void local_residual(const MatrixFree<dim, Number> &data, VectorType &dst,
+                      const VectorType &src,
+                      const std::pair<unsigned int, unsigned int> &range) const {
+    FECellIntegrator phi(data);
+    FECellIntegrator phi_old(data);
+    FECellIntegrator phi_older(data);
+
+    // The explicit part of the theta method needs the gradient of u_old, and
+    // only BDF2 needs u_older.
+    const bool explicit_part = theta < 1.0;
+    const bool bdf2 = time_coefficients[2] != 0.0;
+
+    const Number a0 = static_cast<Number>(time_coefficients[0] / deltat);
+    const Number a1 = static_cast<Number>(time_coefficients[1] / deltat);
+    const Number a2 = static_cast<Number>(time_coefficients[2] / deltat);
+    const Number implicit_reaction = static_cast<Number>(theta * alpha);
+    const Number explicit_reaction =
+        static_cast<Number>((1.0 - theta) * alpha);
+    const Number implicit_diffusion = static_cast<Number>(theta);
+    const Number explicit_diffusion = static_cast<Number>(1.0 - theta);
+
+    for (unsigned int cell = range.first; cell < range.second; ++cell) {
+      phi.reinit(cell);
+      phi.read_dof_values_plain(src);
+      phi.evaluate(EvaluationFlags::values | EvaluationFlags::gradients);
+
+      phi_old.reinit(cell);
+      phi_old.read_dof_values_plain(*solution_old);
+      phi_old.evaluate(explicit_part ? EvaluationFlags::values |
+                                           EvaluationFlags::gradients
+                                     : EvaluationFlags::values);
+
+      if (bdf2) {
+        phi_older.reinit(cell);
+        phi_older.read_dof_values_plain(*solution_older);
+        phi_older.evaluate(EvaluationFlags::values);
+      }
+
+      for (unsigned int q = 0; q < phi.n_q_points; ++q) {
+        const VectorizedArray<Number> u = phi.get_value(q);
+        const VectorizedArray<Number> u_old = phi_old.get_value(q);
+
+        // Time derivative term.
+        VectorizedArray<Number> value = -(a0 * u + a1 * u_old);
+        if (bdf2)
+          value -= a2 * phi_older.get_value(q);
+
+        // Reaction term.
+        value += implicit_reaction * u * (Number(1.0) - u);
+        if (explicit_part)
+          value += explicit_reaction * u_old * (Number(1.0) - u_old);
+
+        phi.submit_value(value, q);
+
+        // Diffusion term.
+        Tensor<1, dim, VectorizedArray<Number>> gradient =
+            implicit_diffusion * phi.get_gradient(q);
+        if (explicit_part)
+          gradient += explicit_diffusion * phi_old.get_gradient(q);
+
+        phi.submit_gradient(-(diffusion_coefficient(cell, q) * gradient), q);
+      }
+
+      phi.integrate(EvaluationFlags::values | EvaluationFlags::gradients);
+      phi.distribute_local_to_global(dst);
+    }
+  }
+
+  // Action of the linearized operator on a single cell batch.
+  void do_cell_integral_local(FECellIntegrator &phi) const {
+    const unsigned int cell = phi.get_current_cell_index();
+
+    integrate_cell(phi, [&](const unsigned int q) {
+      return reaction_coefficient(cell, q);
+    });
+  }
+
+  // Action of the linearized operator on a cell batch, given the
+  // linearized reaction coefficient at each quadrature point.
+  template <typename ReactionCoefficient>
+  void integrate_cell(FECellIntegrator &phi,
+                      const ReactionCoefficient &reaction) const {
+    const unsigned int cell = phi.get_current_cell_index();
+
+    const Number mass_coefficient =
+        static_cast<Number>(time_coefficients[0] / deltat);
+    const Number diffusion_weight = static_cast<Number>(theta);
+
+    phi.evaluate(EvaluationFlags::values | EvaluationFlags::gradients);
+
+    for (unsigned int q = 0; q < phi.n_q_points; ++q) {
+      // Mass and reaction terms.
+      phi.submit_value((mass_coefficient - reaction(q)) * phi.get_value(q), q);
+
+      // Diffusion term.
+      phi.submit_gradient(diffusion_weight * (diffusion_coefficient(cell, q) *
+                                              phi.get_gradient(q)),
+                          q);
+    }
+
+    phi.integrate(EvaluationFlags::values | EvaluationFlags::gradients);
+  }
+
+  // Reaction coefficient.
+  double alpha;
+
+  // Time step.
+  double deltat;
+
+  // Coefficients of the time derivative (backward Euler by default).
+  std::array<double, 3> time_coefficients = {{1.0, -1.0, 0.0}};
+
+  // Weight of the implicit part of the diffusion and reaction terms.
+  double theta = 1.0;
+
+  // Diffusion tensor at the quadrature points of each cell batch.
+  Table<2, Tensor<2, dim, VectorizedArray<Number>>> diffusion_coefficient;
+
+  // Linearized reaction coefficient theta alpha (1 - 2 u) at the quadrature
+  // points.
+  Table<2, VectorizedArray<Number>> reaction_coefficient;
+
+  // Vector around which the reaction term is linearized in each product,
+  // instead of the stored coefficient.
+  const VectorType *linearization_point = nullptr;
+
+  // Solutions at the two previous time steps, during the residual
+  // evaluation.
+  const VectorType *solution_old = nullptr;
+  const VectorType *solution_older = nullptr;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef JACOBIAN_OPERATOR_GPU_HPP
+#define JACOBIAN_OPERATOR_GPU_HPP
+
+#include <deal.II/base/cuda.h>
+#include <deal.II/base/quadrature_lib.h>
+
+#include <deal.II/distributed/tria_base.h>
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/fe/mapping_q.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/cuda_vector.h>
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <deal.II/matrix_free/cuda_fe_evaluation.h>
+#include <deal.II/matrix_free/cuda_matrix_free.h>
+
+#include <string>
+
+using namespace dealii;
+
+// Parameters of the diffusion tensor. The tensor classes of
+// DiffusionTensor.hpp are virtual and live on the host, so the GPU kernels
+// evaluate the same fiber fields from these plain values.
+struct DiffusionTensorData {
+  enum class Type { isotropic, radial, circumferential };
+
+  Type type;
+  double dext;
+  double daxn;
+  double center[3];
+
+  static Type type_from_string(const std::string &name) {
+    AssertThrow(name != "Fiber field",
+                ExcMessage("The GPU solver only evaluates the analytic "
+                           "diffusion tensors, not Fiber field."));
+
+    if (name == "Isotropic")
+      return Type::isotropic;
+    else if (name == "Radial")
+      return Type::radial;
+    else if (name == "Circumferential")
+      return Type::circumferential;
+
+    AssertThrow(false, ExcMessage("Unknown diffusion tensor type " + name));
+    return Type::radial;
+  }
+};
+
+// Evaluate the diffusion tensor at the quadrature points of each cell. The
+// entries of the tensor at the quadrature point pos are stored at
+// coefficient[pos * dim * dim].
+template <int dim, int fe_degree>
+class DiffusionCoefficientFunctor {
+public:
+  DiffusionCoefficientFunctor(double *coefficient_,
+                              const DiffusionTensorData &tensor_)
+      : coefficient(coefficient_), tensor(tensor_) {}
+
+  __device__ void
+  operator()(const unsigned int cell,
+             const typename CUDAWrappers::MatrixFree<dim, double>::Data
+                 *gpu_data) {
+    const unsigned int pos = CUDAWrappers::local_q_point_id<dim, double>(
+        cell, gpu_data, n_dofs_1d, n_q_points);
+    const Point<dim> p = CUDAWrappers::get_quadrature_point<dim, double>(
+        cell, gpu_data, n_dofs_1d);
+
+    double fiber[dim] = {};
+    if (tensor.type == DiffusionTensorData::Type::radial) {
+      double dist = 0.0;
+      for (unsigned int i = 0; i < dim; ++i)
+        dist += (p[i] - tensor.center[i]) * (p[i] - tensor.center[i]);
+      dist = sqrt(dist) + 1e-6;
+
+      for (unsigned int i = 0; i < dim; ++i)
+        fiber[i] = (p[i] - tensor.center[i]) / dist;
+    } else if (tensor.type == DiffusionTensorData::Type::circumferential) {
+      const double dy = p[1] - tensor.center[1];
+      const double dz = p[2] - tensor.center[2];
+      const double dist = sqrt(dy * dy + dz * dz) + 1e-6;
+
+      fiber[1] = -dz / dist;
+      fiber[2] = dy / dist;
+    }
+
+    for (unsigned int i = 0; i < dim; ++i)
+      for (unsigned int j = 0; j < dim; ++j)
+        coefficient[pos * dim * dim + i * dim + j] =
+            (i == j ? tensor.dext : 0.0) + tensor.daxn * fiber[i] * fiber[j];
+  }
+
+  static const unsigned int n_dofs_1d = fe_degree + 1;
+  static const unsigned int n_local_dofs = Utilities::pow(n_dofs_1d, dim);
+  static const unsigned int n_q_points = Utilities::pow(n_dofs_1d, dim);
+
+private:
+  double *coefficient;
+  const DiffusionTensorData tensor;
+};
+
+// Terms of the Fisher-Kolmogorov operators evaluated by a cell kernel.
+enum class GPUOperatorType {
+  // Linearized operator J(u) v = M v / deltat + K v - alpha (1 - 2 u) M v.
+  jacobian,
+  // Residual (with changed sign) without the previous solution,
+  // -M u / deltat - K u + alpha M u (1 - u).
+  residual,
+  // Mass matrix scaled by 1 / deltat.
+  mass,
+  // Store alpha (1 - 2 u) at the quadrature points, without integrating.
+  linearization
+};
+
+// Operation at a single quadrature point. Each thread of the cell kernel
+// handles one quadrature point, with index pos in the coefficient arrays.
+template <int dim, int fe_degree>
+class FisherKolmogorovQuad {
+public:
+  using FEEvaluationType =
+      CUDAWrappers::FEEvaluation<dim, fe_degree, fe_degree + 1, 1, double>;
+
+  __device__ FisherKolmogorovQuad(const GPUOperatorType type_,
+                                  const unsigned int pos_, const double alpha_,
+                                  const double deltat_,
+                                  const double *diffusion_coefficient_,
+                                  double *reaction_coefficient_)
+      : type(type_), pos(pos_), alpha(alpha_), deltat(deltat_),
+        diffusion_coefficient(diffusion_coefficient_),
+        reaction_coefficient(reaction_coefficient_) {}
+
+  __device__ void operator()(FEEvaluationType *fe_eval) const {
+    const double u = fe_eval->get_value();
+
+    if (type == GPUOperatorType::linearization) {
+      reaction_coefficient[pos] = alpha * (1.0 - 2.0 * u);
+      return;
+    }
+
+    if (type == GPUOperatorType::mass) {
+      fe_eval->submit_value(u / deltat);
+      return;
+    }
+
+    if (type == GPUOperatorType::jacobian)
+      fe_eval->submit_value((1.0 / deltat - reaction_coefficient[pos]) * u);
+    else
+      fe_eval->submit_value(-u / deltat + alpha * u * (1.0 - u));
+
+    const double sign = (type == GPUOperatorType::jacobian) ? 1.0 : -1.0;
+    const auto grad_u = fe_eval->get_gradient();
+    auto flux = grad_u;
+    for (unsigned int i = 0; i < dim; ++i) {
+      flux[i] = 0.0;
+      for (unsigned int j = 0; j < dim; ++j)
+        flux[i] += diffusion_coefficient[pos * dim * dim + i * dim + j] *
+                   grad_u[j];
+      flux[i] *= sign;
+    }
+    fe_eval->submit_gradient(flux);
+  }
+
+private:
+  const GPUOperatorType type;
+  const unsigned int pos;
+  const double alpha;
+  const double deltat;
+  const double *diffusion_coefficient;
+  double *reaction_coefficient;
+};
+
+// Cell kernel of the operators, with sum factorization on hexahedra.
+template <int dim, int fe_degree>
+class LocalFisherKolmogorovOperator {
+public:
+  LocalFisherKolmogorovOperator(const GPUOperatorType type_,
+                                const double alpha_, const double deltat_,
+                                const double *diffusion_coefficient_,
+                                double *reaction_coefficient_)
+      : type(type_), alpha(alpha_), deltat(deltat_),
+        diffusion_coefficient(diffusion_coefficient_),
+        reaction_coefficient(reaction_coefficient_) {}
+
+  __device__ void
+  operator()(const unsigned int cell,
+             const typename CUDAWrappers::MatrixFree<dim, double>::Data
+                 *gpu_data,
+             CUDAWrappers::SharedData<dim, double> *shared_data,
+             const double *src, double *dst) const {
+    const unsigned int pos = CUDAWrappers::local_q_point_id<dim, double>(
+        cell, gpu_data, n_dofs_1d, n_q_points);
+
+    typename FisherKolmogorovQuad<dim, fe_degree>::FEEvaluationType fe_eval(
+        cell, gpu_data, shared_data);
+
+    const bool gradients = (type == GPUOperatorType::jacobian ||
+                            type == GPUOperatorType::residual);
+
+    fe_eval.read_dof_values(src);
+    fe_eval.evaluate(true, gradients);
+    fe_eval.apply_for_each_quad_point(FisherKolmogorovQuad<dim, fe_degree>(
+        type, pos, alpha, deltat, diffusion_coefficient,
+        reaction_coefficient));
+
+    if (type == GPUOperatorType::linearization)
+      return;
+
+    fe_eval.integrate(true, gradients);
+    fe_eval.distribute_local_to_global(dst);
+  }
+
+  static const unsigned int n_dofs_1d = fe_degree + 1;
+  static const unsigned int n_local_dofs = Utilities::pow(fe_degree + 1, dim);
+  static const unsigned int n_q_points = Utilities::pow(fe_degree + 1, dim);
+
+private:
+  const GPUOperatorType type;
+  const double alpha;
+  const double deltat;
+  const double *diffusion_coefficient;
+  double *reaction_coefficient;
+};
+
+// Matrix-free Jacobian and residual of the Fisher-Kolmogorov problem on the
+// GPU. This is the CUDA counterpart of JacobianOperator: the coefficients
+// are stored in device memory at the quadrature points, and the cell
+// integrals are evaluated by one CUDA thread per quadrature point. The
+// polynomial degree is a template argument of the CUDA kernels.
+template <int dim, int fe_degree>
+class JacobianOperatorGPU {
+public:
+  using VectorType =
+      LinearAlgebra::distributed::Vector<double, MemorySpace::CUDA>;
+
+  JacobianOperatorGPU(const DoFHandler<dim> &dof_handler,
+                      const AffineConstraints<double> &constraints,
+                      const DiffusionTensorData &tensor, const double alpha_,
+                      const double deltat_)
+      : alpha(alpha_), deltat(deltat_) {
+    // The same linear mapping as the CPU solver, so that both integrate on
+    // the same cells.
+    MappingQGeneric<dim> mapping(1);
+
+    typename CUDAWrappers::MatrixFree<dim, double>::AdditionalData
+        additional_data;
+    additional_data.mapping_update_flags = update_values | update_gradients |
+                                           update_JxW_values |
+                                           update_quadrature_points;
+
+    const QGauss<1> quadrature(fe_degree + 1);
+    mf_data.reinit(mapping, dof_handler, constraints, quadrature,
+                   additional_data);
+
+    const unsigned int n_owned_cells =
+        dynamic_cast<const parallel::TriangulationBase<dim> &>(
+            dof_handler.get_triangulation())
+            .n_locally_owned_active_cells();
+    const unsigned int n_q_points = Utilities::pow(fe_degree + 1, dim);
+
+    // The diffusion tensor does not depend on the solution, so it is
+    // evaluated once at all quadrature points.
+    diffusion_coefficient.reinit(dim * dim * n_q_points * n_owned_cells);
+    reaction_coefficient.reinit(n_q_points * n_owned_cells);
+
+    DiffusionCoefficientFunctor<dim, fe_degree> functor(
+        diffusion_coefficient.get_values(), tensor);
+    mf_data.evaluate_coefficients(functor);
+
+    initialize_dof_vector(linearization_dst);
+  }
+
+  // Change the time step of the mass term.
+  void set_time_step(const double deltat_) { deltat = deltat_; }
+
+  // Linearize the reaction term around the current Newton iterate.
+  void evaluate_newton_step(const VectorType &solution) {
+    mf_data.cell_loop(local_operator(GPUOperatorType::linearization), solution,
+                      linearization_dst);
+  }
+
+  // Evaluate the residual (with changed sign) of the time step at the given
+  // solution.
+  void evaluate_residual(VectorType &dst, const VectorType &solution,
+                         const VectorType &solution_old) const {
+    dst = 0.0;
+    mf_data.cell_loop(local_operator(GPUOperatorType::residual), solution,
+                      dst);
+    mf_data.cell_loop(local_operator(GPUOperatorType::mass), solution_old,
+                      dst);
+    mf_data.set_constrained_values(0.0, dst);
+  }
+
+  // Action of the Jacobian, as used by the CG solver.
+  void vmult(VectorType &dst, const VectorType &src) const {
+    dst = 0.0;
+    mf_data.cell_loop(local_operator(GPUOperatorType::jacobian), src, dst);
+    mf_data.copy_constrained_values(src, dst);
+  }
+
+  void initialize_dof_vector(VectorType &vector) const {
+    mf_data.initialize_dof_vector(vector);
+  }
+
+private:
+  LocalFisherKolmogorovOperator<dim, fe_degree>
+  local_operator(const GPUOperatorType type) const {
+    return LocalFisherKolmogorovOperator<dim, fe_degree>(
+        type, alpha, deltat, diffusion_coefficient.get_values(),
+        reaction_coefficient.get_values());
+  }
+
+  CUDAWrappers::MatrixFree<dim, double> mf_data;
+
+  // Reaction coefficient.
+  double alpha;
+
+  // Time step.
+  double deltat;
+
+  // Diffusion tensor at the quadrature points of each cell, in device memory.
+  LinearAlgebra::CUDAWrappers::Vector<double> diffusion_coefficient;
+
+  // Linearized reaction coefficient alpha (1 - 2 u) at the quadrature points.
+  LinearAlgebra::CUDAWrappers::Vector<double> reaction_coefficient;
+
+  // Destination of the linearization cell loop, which writes nothing into
+  // it. Allocated once instead of at every Newton iteration.
+  VectorType linearization_dst;
+};
+
+#endif
@@ -4,8 +4,10 @@
 #include "DiffusionTensor.hpp"
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/subscriptor.h>
+#include <deal.II/base/utilities.h>
 #include <deal.II/numerics/data_out.h>
 #include <string>
+#include <vector>
 
 using namespace dealii;
 
@@ -16,17 +18,106 @@ struct SimulationParameters {
 
   double T;       // Final time
   double deltat;  // Time step size
+  double theta;   // Theta of the time-stepping method
+  std::string time_integrator;           // Newton, Strang or IMEX
+  std::string time_scheme;               // Theta or BDF2 (Newton integrator)
+  bool adaptive_time_stepping;           // Adapt the time step
+  double deltat_min;                     // Smallest time step
+  double deltat_max;                     // Largest time step
+  unsigned int target_newton_iterations; // Newton iterations per step aimed at
+  unsigned int target_cg_iterations;     // CG iterations per solve aimed at
+  double deltat_growth_factor;           // Time step growth after easy steps
   unsigned int r; // Polynomial degree
+  std::string mesh_file; // Path to the mesh file
 
   unsigned int max_newton_iterations; // Max iterations for Newton's method
   double newton_tolerance;            // Tolerance for Newton's method
   unsigned int max_cg_iterations;     // Max iterations for CG solver
   double cg_tolerance_factor;         // Tolerance factor for CG solver
+  std::string linear_solver;          // Krylov solver (CG or PipeCG)
+  bool matrix_free;                   // Apply the Jacobian matrix-free
+  bool mixed_precision;               // Single-precision inner linear solves
+  bool split_assembly;                // Assemble M / deltat + K only once
+  std::string predictor;              // Predictor of the Newton initial guess
+  unsigned int n_threads;             // Threads per MPI process
+  bool lumped_reaction;               // Lump the reaction mass matrix
+  bool active_region_assembly;        // Skip the quadrature away from the front
+  double active_region_tolerance;     // Distance from 0 or 1 of plateau cells
+  unsigned int active_region_halo;    // Cell layers added around the front
+  unsigned int active_cell_weight;    // Load-balancing weight of front cells
+  bool communication_overlap;         // Overlap ghost exchange and assembly
+
+  bool inexact_newton;             // Eisenstat-Walker CG tolerance
+  double forcing_gamma;            // Forcing term gamma
+  double forcing_exponent;         // Forcing term exponent
+  double max_forcing_term;         // Largest forcing term
+  bool jacobian_reuse;             // Keep the Jacobian (modified Newton)
+  double jacobian_reuse_threshold; // Residual reduction to keep the Jacobian
+
+  std::string preconditioner;                   // Preconditioner type
+  unsigned int preconditioner_rebuild_interval; // Time steps between rebuilds
+  std::string amg_smoother_type;                // AMG smoother type
+  unsigned int amg_smoother_sweeps;             // AMG smoother sweeps
+  double amg_aggregation_threshold;             // AMG aggregation threshold
+  double operator_cache_threshold;              // Jacobian change to reuse it
+
+  std::string output_format;    // Output format (VTU or HDF5)
+  unsigned int output_interval; // Time steps between outputs
+  double output_time_interval;  // Time between outputs (0 = use steps)
+  bool write_partitioning;      // Write the partitioning field
+  bool asynchronous_output;     // Write from a background thread
+  std::string benchmark_file;   // CSV record of the run (empty = none)
+  std::string metrics_file;     // Per-step metrics stream (empty = none)
+  std::string metrics_format;   // CSV or JSON lines
+
+  std::string mesh_loading;          // Serial or Groups mesh loading
+  unsigned int mesh_group_size;      // Processes per mesh reading group
+  bool mesh_cache;                   // Cache the partitioned mesh
+  std::string mesh_cache_directory;  // Directory of the cached mesh
+  std::string partitioner;           // METIS, Zoltan or Hilbert
+  unsigned int seed_cell_weight;     // Partitioner weight of seed cells
+  std::string dof_renumbering;       // None, Cuthill-McKee or Hilbert
+  std::string element_type;          // Tetrahedra or Hexahedra
+
+  bool adaptive_refinement;               // Adaptively refine the mesh
+  unsigned int refinement_interval;       // Time steps between refinements
+  std::string refinement_indicator;       // Kelly or Gradient
+  double refine_fraction;                 // Error fraction of refined cells
+  double coarsen_fraction;                // Error fraction of coarsened cells
+  unsigned int max_refinement_level;      // Maximum refinement level
+  unsigned int initial_refinement_cycles; // Cycles on the initial condition
+  unsigned int rebalance_interval;        // Time steps between rebalancings
+  std::string rebalance_cost;             // Front or Measured cell cost
+  double rebalance_threshold;             // Tolerated max/average load
+
+  unsigned int checkpoint_interval;  // Time steps between checkpoints
+  std::string checkpoint_directory;  // Directory of the checkpoint files
+  bool restart;                      // Restart from the last checkpoint
 
   std::string diffusion_tensor_type; // Type of diffusion tensor
   Point<3> tensor_center;            // Center point for directional tensors
+  std::string fiber_field_file;      // Voxel field of the fiber directions
+
+  // Fiber field, read once and shared by the tensors of all the runs.
+  std::shared_ptr<const FiberField> fiber_field;
 
   std::shared_ptr<DiffusionTensor<3>> diffusion_tensor;
+
+  bool ensemble;                                  // Run a parameter sweep
+  std::vector<double> ensemble_dext;              // Dext of the sweep
+  std::vector<double> ensemble_daxn;              // Daxn of the sweep
+  std::vector<double> ensemble_alpha;             // Alpha of the sweep
+  std::vector<std::string> ensemble_tensor_types; // Tensor types of the sweep
+
+  unsigned int snapshot_interval;             // Time steps between snapshots
+  double pod_tolerance;                       // Energy left out of the POD
+  unsigned int max_pod_modes;                 // Largest number of POD modes
+  double deim_tolerance;                      // Energy left out of the DEIM
+  unsigned int max_deim_points;               // Largest number of DEIM points
+  std::vector<double> online_dext;            // Dext of the ROM runs
+  std::vector<double> online_daxn;            // Daxn of the ROM runs
+  std::vector<double> online_alpha;           // Alpha of the ROM runs
+  std::vector<std::string> online_tensor_types; // Tensor types of the ROM runs
 };
 
 /**
@@ -46,6 +137,15 @@ public:
    */
   SimulationParameters read_parameters(const std::string &parameter_file);
 
+  /**
+   * Expand the ensemble of a parameter sweep: one set of parameters, with
+   * its own diffusion tensor, for each combination of the listed values.
+   * An empty list keeps the value of the single-run parameters.
+   * @param params The simulation parameters
+   */
+  std::vector<SimulationParameters>
+  ensemble_members(const SimulationParameters &params);
+
 private:
   /**
    * Declare all parameters that can be specified in the parameter file.
@@ -74,6 +174,86 @@ void ParameterReader::declare_parameters() {
                       Patterns::Anything(), "Path to the mesh file");
     prm.declare_entry("Degree", "1", Patterns::Integer(1),
                       "Polynomial degree of finite element");
+
+    prm.declare_entry("Mesh loading", "Serial",
+                      Patterns::Selection("Serial|Groups"),
+                      "Every process reads and partitions the whole mesh "
+                      "(Serial), or one process per group does and sends "
+                      "each process of the group only its part (Groups)");
+
+    prm.declare_entry("Group size", "0", Patterns::Integer(0),
+                      "Processes per group with Groups loading "
+                      "(0 = a single group, only one process reads the mesh)");
+
+    prm.declare_entry("Mesh cache", "false", Patterns::Bool(),
+                      "Store the partitioned mesh in binary form and read it "
+                      "instead of the Gmsh file in later runs with the same "
+                      "number of processes");
+
+    prm.declare_entry("Mesh cache directory", "mesh-cache",
+                      Patterns::Anything(),
+                      "Directory of the cached partitioned mesh");
+
+    prm.declare_entry("Partitioner", "METIS",
+                      Patterns::Selection("METIS|Zoltan|Hilbert"),
+                      "Graph partitioner of the mesh (METIS or Zoltan), or "
+                      "cells sorted along a Hilbert space-filling curve "
+                      "(Hilbert)");
+
+    prm.declare_entry("Seed cell weight", "1", Patterns::Integer(1),
+                      "Partitioner weight of the cells where the initial "
+                      "condition is positive (other cells weigh 1)");
+
+    prm.declare_entry("Element type", "Tetrahedra",
+                      Patterns::Selection("Tetrahedra|Hexahedra"),
+                      "Use the tetrahedra of the mesh file, or split each of "
+                      "them into four hexahedra (required by the adaptive "
+                      "refinement)");
+
+    prm.declare_entry("Adaptive refinement", "false", Patterns::Bool(),
+                      "Refine and coarsen the hexahedral mesh to follow the "
+                      "front");
+
+    prm.declare_entry("Refinement interval", "5", Patterns::Integer(1),
+                      "Time steps between two refinement cycles");
+
+    prm.declare_entry("Refinement indicator", "Kelly",
+                      Patterns::Selection("Kelly|Gradient"),
+                      "Kelly error estimator, or gradient of the solution "
+                      "weighted with the cell size");
+
+    prm.declare_entry("Refine fraction", "0.3", Patterns::Double(0, 1),
+                      "Fraction of the estimated error of the refined cells");
+
+    prm.declare_entry("Coarsen fraction", "0.3", Patterns::Double(0, 1),
+                      "Fraction of the estimated error of the coarsened "
+                      "cells");
+
+    prm.declare_entry("Max refinement level", "2", Patterns::Integer(0),
+                      "Maximum number of refinements of a cell of the mesh "
+                      "file");
+
+    prm.declare_entry("Initial refinement cycles", "0", Patterns::Integer(0),
+                      "Refinement cycles applied to the initial condition");
+
+    prm.declare_entry("Rebalance interval", "0", Patterns::Integer(0),
+                      "Time steps between two checks of the load balance of "
+                      "the hexahedral mesh (0 = never rebalance)");
+
+    prm.declare_entry("Rebalance cost", "Front",
+                      Patterns::Selection("Front|Measured"),
+                      "Cost of a cell: Active cell weight around the front "
+                      "and 1 elsewhere (Front), or its assembly time since "
+                      "the last check (Measured)");
+
+    prm.declare_entry("Rebalance threshold", "1.1", Patterns::Double(1),
+                      "Largest load of a process, relative to the average, "
+                      "before the mesh is repartitioned");
+
+    prm.declare_entry("DoF renumbering", "None",
+                      Patterns::Selection("None|Cuthill-McKee|Hilbert"),
+                      "Renumbering of the locally owned DoFs after "
+                      "distribute_dofs");
   }
   prm.leave_subsection();
 
@@ -97,7 +277,42 @@ void ParameterReader::declare_parameters() {
 
     prm.declare_entry(
         "Theta", "1.0", Patterns::Double(0.0, 1.0),
-        "Theta value for the time-stepping method (0=explicit, 1=implicit)");
+        "Theta value for the time-stepping method (0=explicit, 1=implicit, "
+        "0.5=Crank-Nicolson)");
+
+    prm.declare_entry("Time integrator", "Newton",
+                      Patterns::Selection("Newton|Strang|IMEX"),
+                      "Fully implicit step solved with Newton's method "
+                      "(Newton), Strang splitting of the exact reaction and "
+                      "a linear diffusion step (Strang), or explicit reaction "
+                      "and implicit diffusion (IMEX)");
+
+    prm.declare_entry("Time scheme", "Theta",
+                      Patterns::Selection("Theta|BDF2"),
+                      "Time discretization of the Newton integrator: the "
+                      "theta method with the given Theta (Theta), or the "
+                      "second-order backward differentiation formula (BDF2)");
+
+    prm.declare_entry("Adaptive time stepping", "false", Patterns::Bool(),
+                      "Adapt the time step to the Newton and CG convergence");
+
+    prm.declare_entry("Min deltat", "0.1", Patterns::Double(0),
+                      "Smallest time step of the adaptive controller");
+
+    prm.declare_entry("Max deltat", "10.0", Patterns::Double(0),
+                      "Largest time step of the adaptive controller");
+
+    prm.declare_entry("Target Newton iterations", "4", Patterns::Integer(1),
+                      "Newton iterations per time step: the time step grows "
+                      "below this value and shrinks above it");
+
+    prm.declare_entry("Target CG iterations", "100", Patterns::Integer(1),
+                      "Average CG iterations per Newton iteration above "
+                      "which the time step shrinks");
+
+    prm.declare_entry("Growth factor", "1.5", Patterns::Double(1.0),
+                      "Factor by which the time step grows after an easy "
+                      "step");
   }
   prm.leave_subsection();
 
@@ -115,6 +330,170 @@ void ParameterReader::declare_parameters() {
     prm.declare_entry(
         "CG tolerance factor", "1e-6", Patterns::Double(0),
         "Tolerance factor for CG solver (multiplied by residual norm)");
+
+    prm.declare_entry("Linear solver", "CG", Patterns::Selection("CG|PipeCG"),
+                      "Krylov solver of the linear systems: conjugate "
+                      "gradient (CG), or pipelined CG with one overlapped "
+                      "reduction per iteration (PipeCG)");
+
+    prm.declare_entry(
+        "Jacobian operator", "Matrix-based",
+        Patterns::Selection("Matrix-based|Matrix-free"),
+        "Assemble the Jacobian (Matrix-based) or apply it on the fly "
+        "(Matrix-free, Jacobi-preconditioned)");
+
+    prm.declare_entry("Linear solver precision", "Double",
+                      Patterns::Selection("Double|Mixed"),
+                      "Precision of the matrix-free linear solves: double, "
+                      "or single-precision operator and CG inside a "
+                      "double-precision defect correction (Mixed)");
+
+    prm.declare_entry("Jacobian assembly", "Full",
+                      Patterns::Selection("Full|Split"),
+                      "Assemble the whole Jacobian at each Newton iteration "
+                      "(Full) or assemble M / deltat + K once and only the "
+                      "reaction term at each iteration (Split)");
+
+    prm.declare_entry("Reaction mass", "Consistent",
+                      Patterns::Selection("Consistent|Lumped"),
+                      "Mass matrix used for the reaction term (Lumped is "
+                      "intended for degree 1)");
+
+    prm.declare_entry("Active region assembly", "false", Patterns::Bool(),
+                      "Assemble the Jacobian from cached cell matrices on the "
+                      "cells where u is uniformly 0 or 1, integrating only "
+                      "around the front");
+
+    prm.declare_entry("Active region tolerance", "1e-6", Patterns::Double(0),
+                      "Largest distance of the nodal values from 0 or 1 on a "
+                      "cell away from the front");
+
+    prm.declare_entry("Active region halo", "1", Patterns::Integer(0),
+                      "Layers of neighbor cells added to the front");
+
+    prm.declare_entry("Active cell weight", "4", Patterns::Integer(1),
+                      "Relative cost of the cells around the front when the "
+                      "hexahedral mesh is repartitioned (1 = uniform)");
+
+    prm.declare_entry("Communication overlap", "false", Patterns::Bool(),
+                      "Assemble the cells that need no ghost values while the "
+                      "ghost values of the solution are exchanged, and while "
+                      "the residual is compressed");
+
+    prm.declare_entry("Number of threads", "0", Patterns::Integer(0),
+                      "Threads per MPI process used for the cell assembly "
+                      "(0 = use all the cores left by the MPI processes)");
+
+    prm.declare_entry("Predictor", "None",
+                      Patterns::Selection("None|Linear|Quadratic|Reaction"),
+                      "Initial guess of Newton's method: the previous "
+                      "solution (None), its linear or quadratic "
+                      "extrapolation from the last steps, or an exact "
+                      "reaction-only step (Reaction)");
+
+    prm.declare_entry("Inexact Newton", "false", Patterns::Bool(),
+                      "Choose the CG tolerance of each Newton iteration from "
+                      "the Eisenstat-Walker forcing term instead of the "
+                      "fixed CG tolerance factor");
+
+    prm.declare_entry("Forcing term gamma", "0.9", Patterns::Double(0, 1),
+                      "Gamma of the forcing term "
+                      "eta_k = gamma (r_k / r_{k-1})^exponent");
+
+    prm.declare_entry("Forcing term exponent", "2.0", Patterns::Double(1, 2),
+                      "Exponent of the forcing term");
+
+    prm.declare_entry("Max forcing term", "0.9", Patterns::Double(0, 1),
+                      "Largest forcing term, used at the first Newton "
+                      "iteration");
+
+    prm.declare_entry("Jacobian reuse", "false", Patterns::Bool(),
+                      "Keep the Jacobian and preconditioner of the previous "
+                      "Newton iteration while the residual drops fast enough "
+                      "(modified Newton)");
+
+    prm.declare_entry("Jacobian reuse threshold", "0.25",
+                      Patterns::Double(0, 1),
+                      "The Jacobian is kept while each Newton iteration "
+                      "reduces the residual by at least this factor");
+
+    prm.declare_entry("Preconditioner", "SSOR",
+                      Patterns::Selection("AMG|SSOR|ILU"),
+                      "Preconditioner for the assembled Jacobian");
+
+    prm.declare_entry("Preconditioner rebuild interval", "1",
+                      Patterns::Integer(0),
+                      "Time steps between preconditioner rebuilds "
+                      "(0 = rebuild at every Newton iteration)");
+
+    prm.declare_entry("AMG smoother type", "Chebyshev",
+                      Patterns::Selection("Chebyshev|symmetric Gauss-Seidel|"
+                                          "Gauss-Seidel|Jacobi|ILU|IC"),
+                      "Smoother used on the AMG levels");
+
+    prm.declare_entry("AMG smoother sweeps", "2", Patterns::Integer(1),
+                      "Number of AMG smoother sweeps");
+
+    prm.declare_entry("AMG aggregation threshold", "1e-4",
+                      Patterns::Double(0),
+                      "Threshold for the AMG aggregation");
+
+    prm.declare_entry("Operator cache threshold", "0.0", Patterns::Double(0),
+                      "Estimated relative change of the Jacobian, "
+                      "2 alpha deltat max |u - u_cached|, below which the "
+                      "assembled Jacobian and its preconditioner are reused, "
+                      "also across time steps (0 = disabled)");
+  }
+  prm.leave_subsection();
+
+  prm.enter_subsection("Output parameters");
+  {
+    prm.declare_entry("Output format", "VTU", Patterns::Selection("VTU|HDF5"),
+                      "One .vtu per process and time step (VTU), or a single "
+                      "collective HDF5 file per time step indexed by an XDMF "
+                      "file (HDF5)");
+
+    prm.declare_entry("Output interval", "1", Patterns::Integer(1),
+                      "Number of time steps between two outputs");
+
+    prm.declare_entry("Output time interval", "0.0", Patterns::Double(0),
+                      "Simulated time between two outputs (0 = use the "
+                      "output interval in time steps)");
+
+    prm.declare_entry("Write partitioning", "true", Patterns::Bool(),
+                      "Write the MPI partitioning field along with u");
+
+    prm.declare_entry("Asynchronous output", "false", Patterns::Bool(),
+                      "Write the files from a background thread while the "
+                      "next time step is solved");
+
+    prm.declare_entry("Benchmark file", "", Patterns::Anything(),
+                      "CSV file the timings and iteration counts of the run "
+                      "are appended to, for the bench_3D target (empty = do "
+                      "not write it)");
+
+    prm.declare_entry("Metrics file", "", Patterns::Anything(),
+                      "File the iterations, phase timings and load imbalance "
+                      "of each time step are streamed to (empty = no "
+                      "metrics)");
+
+    prm.declare_entry("Metrics format", "CSV", Patterns::Selection("CSV|JSON"),
+                      "One CSV row or one JSON object per line and time step");
+  }
+  prm.leave_subsection();
+
+  prm.enter_subsection("Checkpoint parameters");
+  {
+    prm.declare_entry("Checkpoint interval", "0", Patterns::Integer(0),
+                      "Number of time steps between two checkpoints "
+                      "(0 = no checkpoints)");
+
+    prm.declare_entry("Checkpoint directory", "checkpoint",
+                      Patterns::Anything(),
+                      "Directory where the checkpoint files are written");
+
+    prm.declare_entry("Restart", "false", Patterns::Bool(),
+                      "Resume the simulation from the last checkpoint");
   }
   prm.leave_subsection();
 
@@ -122,7 +501,7 @@ void ParameterReader::declare_parameters() {
   {
     prm.declare_entry(
         "Diffusion tensor type", "Isotropic",
-        Patterns::Selection("Isotropic|Radial|Circumferential"),
+        Patterns::Selection("Isotropic|Radial|Circumferential|Fiber field"),
         "Type of diffusion tensor to use");
 
     prm.declare_entry("Center X", "55.0", Patterns::Double(),
@@ -133,6 +512,78 @@ void ParameterReader::declare_parameters() {
 
     prm.declare_entry("Center Z", "65.0", Patterns::Double(),
                       "Z coordinate of center point for directional tensors");
+
+    prm.declare_entry("Fiber field file", "", Patterns::Anything(),
+                      "Fiber directions of the Fiber field tensor: a NIfTI-1 "
+                      "vector image (.nii) or a raw FKFIBERS file");
+  }
+  prm.leave_subsection();
+
+  prm.enter_subsection("Ensemble parameters");
+  {
+    prm.declare_entry("Ensemble", "false", Patterns::Bool(),
+                      "Run every combination of the values below on the same "
+                      "mesh, DoF handler and sparsity pattern");
+
+    prm.declare_entry("Dext values", "", Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of Dext (empty = Dext)");
+
+    prm.declare_entry("Daxn values", "", Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of Daxn (empty = Daxn)");
+
+    prm.declare_entry("Alpha values", "", Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of alpha "
+                      "(empty = Alpha coefficient)");
+
+    prm.declare_entry(
+        "Diffusion tensor types", "",
+        Patterns::List(Patterns::Selection(
+            "Isotropic|Radial|Circumferential|Fiber field")),
+        "Comma-separated diffusion tensor types "
+        "(empty = Diffusion tensor type)");
+  }
+  prm.leave_subsection();
+
+  prm.enter_subsection("Reduced-order model parameters");
+  {
+    prm.declare_entry("Snapshot interval", "1", Patterns::Integer(1),
+                      "Time steps between two snapshots of the training runs");
+
+    prm.declare_entry("POD tolerance", "1e-6", Patterns::Double(0, 1),
+                      "Fraction of the snapshot energy left out of the POD "
+                      "basis");
+
+    prm.declare_entry("Max POD modes", "50", Patterns::Integer(1),
+                      "Largest number of POD modes");
+
+    prm.declare_entry("DEIM tolerance", "1e-6", Patterns::Double(0, 1),
+                      "Fraction of the reaction term energy left out of the "
+                      "DEIM basis");
+
+    prm.declare_entry("Max DEIM points", "50", Patterns::Integer(1),
+                      "Largest number of DEIM interpolation points");
+
+    prm.declare_entry("Online Dext values", "",
+                      Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of Dext of the reduced runs "
+                      "(empty = Dext)");
+
+    prm.declare_entry("Online Daxn values", "",
+                      Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of Daxn of the reduced runs "
+                      "(empty = Daxn)");
+
+    prm.declare_entry("Online alpha values", "",
+                      Patterns::List(Patterns::Double(0)),
+                      "Comma-separated values of alpha of the reduced runs "
+                      "(empty = Alpha coefficient)");
+
+    prm.declare_entry(
+        "Online diffusion tensor types", "",
+        Patterns::List(Patterns::Selection(
+            "Isotropic|Radial|Circumferential|Fiber field")),
+        "Comma-separated diffusion tensor types of the reduced runs "
+        "(empty = Diffusion tensor type)");
   }
   prm.leave_subsection();
 }
@@ -150,6 +601,11 @@ void ParameterReader::create_diffusion_tensor(SimulationParameters &params) {
     params.diffusion_tensor =
         std::make_shared<CircumferentialDiffusionTensor<3>>(
             params.dext, params.daxn, cir_center);
+  } else if (params.diffusion_tensor_type == "Fiber field") {
+    AssertThrow(params.fiber_field != nullptr,
+                ExcMessage("The Fiber field tensor needs a Fiber field file."));
+    params.diffusion_tensor = std::make_shared<FiberFieldDiffusionTensor<3>>(
+        params.dext, params.daxn, params.fiber_field);
   } else {
     // Default to Radial if something goes wrong
     std::cerr << "Unknown diffusion tensor type: "
@@ -180,6 +636,26 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
     // Read parameters as before
     prm.enter_subsection("Mesh & geometry parameters");
     params.r = prm.get_integer("Degree");
+    params.mesh_file = prm.get("Mesh file");
+    params.mesh_loading = prm.get("Mesh loading");
+    params.mesh_group_size = prm.get_integer("Group size");
+    params.mesh_cache = prm.get_bool("Mesh cache");
+    params.mesh_cache_directory = prm.get("Mesh cache directory");
+    params.partitioner = prm.get("Partitioner");
+    params.seed_cell_weight = prm.get_integer("Seed cell weight");
+    params.dof_renumbering = prm.get("DoF renumbering");
+    params.element_type = prm.get("Element type");
+    params.adaptive_refinement = prm.get_bool("Adaptive refinement");
+    params.refinement_interval = prm.get_integer("Refinement interval");
+    params.refinement_indicator = prm.get("Refinement indicator");
+    params.refine_fraction = prm.get_double("Refine fraction");
+    params.coarsen_fraction = prm.get_double("Coarsen fraction");
+    params.max_refinement_level = prm.get_integer("Max refinement level");
+    params.initial_refinement_cycles =
+        prm.get_integer("Initial refinement cycles");
+    params.rebalance_interval = prm.get_integer("Rebalance interval");
+    params.rebalance_cost = prm.get("Rebalance cost");
+    params.rebalance_threshold = prm.get_double("Rebalance threshold");
     prm.leave_subsection();
 
     prm.enter_subsection("Physical constants");
@@ -191,6 +667,16 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
     prm.enter_subsection("Time stepping parameters");
     params.T = prm.get_double("T");
     params.deltat = prm.get_double("deltat");
+    params.theta = prm.get_double("Theta");
+    params.time_integrator = prm.get("Time integrator");
+    params.time_scheme = prm.get("Time scheme");
+    params.adaptive_time_stepping = prm.get_bool("Adaptive time stepping");
+    params.deltat_min = prm.get_double("Min deltat");
+    params.deltat_max = prm.get_double("Max deltat");
+    params.target_newton_iterations =
+        prm.get_integer("Target Newton iterations");
+    params.target_cg_iterations = prm.get_integer("Target CG iterations");
+    params.deltat_growth_factor = prm.get_double("Growth factor");
     prm.leave_subsection();
 
     prm.enter_subsection("Solver parameters");
@@ -198,6 +684,51 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
     params.newton_tolerance = prm.get_double("Newton tolerance");
     params.max_cg_iterations = prm.get_integer("Max CG iterations");
     params.cg_tolerance_factor = prm.get_double("CG tolerance factor");
+    params.linear_solver = prm.get("Linear solver");
+    params.matrix_free = prm.get("Jacobian operator") == "Matrix-free";
+    params.mixed_precision = prm.get("Linear solver precision") == "Mixed";
+    params.split_assembly = prm.get("Jacobian assembly") == "Split";
+    params.lumped_reaction = prm.get("Reaction mass") == "Lumped";
+    params.active_region_assembly = prm.get_bool("Active region assembly");
+    params.active_region_tolerance = prm.get_double("Active region tolerance");
+    params.active_region_halo = prm.get_integer("Active region halo");
+    params.active_cell_weight = prm.get_integer("Active cell weight");
+    params.communication_overlap = prm.get_bool("Communication overlap");
+    params.n_threads = prm.get_integer("Number of threads");
+    params.predictor = prm.get("Predictor");
+    params.inexact_newton = prm.get_bool("Inexact Newton");
+    params.forcing_gamma = prm.get_double("Forcing term gamma");
+    params.forcing_exponent = prm.get_double("Forcing term exponent");
+    params.max_forcing_term = prm.get_double("Max forcing term");
+    params.jacobian_reuse = prm.get_bool("Jacobian reuse");
+    params.jacobian_reuse_threshold =
+        prm.get_double("Jacobian reuse threshold");
+    params.preconditioner = prm.get("Preconditioner");
+    params.preconditioner_rebuild_interval =
+        prm.get_integer("Preconditioner rebuild interval");
+    params.amg_smoother_type = prm.get("AMG smoother type");
+    params.amg_smoother_sweeps = prm.get_integer("AMG smoother sweeps");
+    params.amg_aggregation_threshold =
+        prm.get_double("AMG aggregation threshold");
+    params.operator_cache_threshold =
+        prm.get_double("Operator cache threshold");
+    prm.leave_subsection();
+
+    prm.enter_subsection("Output parameters");
+    params.output_format = prm.get("Output format");
+    params.output_interval = prm.get_integer("Output interval");
+    params.output_time_interval = prm.get_double("Output time interval");
+    params.write_partitioning = prm.get_bool("Write partitioning");
+    params.asynchronous_output = prm.get_bool("Asynchronous output");
+    params.benchmark_file = prm.get("Benchmark file");
+    params.metrics_file = prm.get("Metrics file");
+    params.metrics_format = prm.get("Metrics format");
+    prm.leave_subsection();
+
+    prm.enter_subsection("Checkpoint parameters");
+    params.checkpoint_interval = prm.get_integer("Checkpoint interval");
+    params.checkpoint_directory = prm.get("Checkpoint directory");
+    params.restart = prm.get_bool("Restart");
     prm.leave_subsection();
 
     prm.enter_subsection("Diffusion tensor parameters");
@@ -205,9 +736,36 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
     params.tensor_center[0] = prm.get_double("Center X");
     params.tensor_center[1] = prm.get_double("Center Y");
     params.tensor_center[2] = prm.get_double("Center Z");
+    params.fiber_field_file = prm.get("Fiber field file");
+    prm.leave_subsection();
+
+    prm.enter_subsection("Ensemble parameters");
+    params.ensemble = prm.get_bool("Ensemble");
+    params.ensemble_dext = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Dext values")));
+    params.ensemble_daxn = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Daxn values")));
+    params.ensemble_alpha = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Alpha values")));
+    params.ensemble_tensor_types =
+        Utilities::split_string_list(prm.get("Diffusion tensor types"));
     prm.leave_subsection();
 
-    create_diffusion_tensor(params);
+    prm.enter_subsection("Reduced-order model parameters");
+    params.snapshot_interval = prm.get_integer("Snapshot interval");
+    params.pod_tolerance = prm.get_double("POD tolerance");
+    params.max_pod_modes = prm.get_integer("Max POD modes");
+    params.deim_tolerance = prm.get_double("DEIM tolerance");
+    params.max_deim_points = prm.get_integer("Max DEIM points");
+    params.online_dext = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Online Dext values")));
+    params.online_daxn = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Online Daxn values")));
+    params.online_alpha = Utilities::string_to_double(
+        Utilities::split_string_list(prm.get("Online alpha values")));
+    params.online_tensor_types = Utilities::split_string_list(
+        prm.get("Online diffusion tensor types"));
+    prm.leave_subsection();
 
   } catch (const std::exception &e) {
     std::ostringstream oss;
@@ -216,7 +774,50 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
     throw std::runtime_error(oss.str());
   }
 
+  // Outside of the block above, so that the errors of reading the fiber
+  // field are reported as they are.
+  if (!params.fiber_field_file.empty())
+    params.fiber_field =
+        std::make_shared<const FiberField>(params.fiber_field_file);
+  create_diffusion_tensor(params);
+
   return params;
 }
 
+std::vector<SimulationParameters>
+ParameterReader::ensemble_members(const SimulationParameters &params) {
+  const auto values_or = [](const std::vector<double> &values,
+                            const double value) {
+    return values.empty() ? std::vector<double>{value} : values;
+  };
+
+  const std::vector<double> dext_values =
+      values_or(params.ensemble_dext, params.dext);
+  const std::vector<double> daxn_values =
+      values_or(params.ensemble_daxn, params.daxn);
+  const std::vector<double> alpha_values =
+      values_or(params.ensemble_alpha, params.alpha);
+  const std::vector<std::string> tensor_types =
+      params.ensemble_tensor_types.empty()
+          ? std::vector<std::string>{params.diffusion_tensor_type}
+          : params.ensemble_tensor_types;
+
+  std::vector<SimulationParameters> members;
+  for (const std::string &tensor_type : tensor_types)
+    for (const double dext : dext_values)
+      for (const double daxn : daxn_values)
+        for (const double alpha : alpha_values) {
+          SimulationParameters member = params;
+          member.diffusion_tensor_type = tensor_type;
+          member.dext = dext;
+          member.daxn = daxn;
+          member.alpha = alpha;
+          create_diffusion_tensor(member);
+
+          members.push_back(member);
+        }
+
+  return members;
+}
+
 #endif // PARAMETER_READER_HPP
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "ReducedOrderModel.hpp"
+
+void ReducedOrderModel::compute_pod_basis(
+    const std::vector<VectorType> &snapshots, const MatrixType &mass,
+    const double tolerance, const unsigned int max_modes) {
+  TimerOutput::Scope t(timer, "ROM offline (POD)");
+
+  basis = pod(snapshots, &mass, tolerance, max_modes);
+
+  pcout << "  POD modes                  = " << basis.size() << " (from "
+        << snapshots.size() << " snapshots)" << std::endl;
+}
+
+void ReducedOrderModel::compute_deim(const std::vector<VectorType> &snapshots,
+                                     const double tolerance,
+                                     const unsigned int max_points) {
+  TimerOutput::Scope t(timer, "ROM offline (DEIM)");
+
+  // Nodal values of the reaction term u (1 - u) at the snapshots.
+  std::vector<VectorType> reaction_snapshots(snapshots.size());
+  for (unsigned int s = 0; s < snapshots.size(); ++s) {
+    reaction_snapshots[s] = snapshots[s];
+    for (const auto i : snapshots[s].locally_owned_elements())
+      reaction_snapshots[s](i) = snapshots[s](i) * (1.0 - snapshots[s](i));
+    reaction_snapshots[s].compress(VectorOperation::insert);
+  }
+
+  deim_basis = pod(reaction_snapshots, nullptr, tolerance, max_points);
+
+  // Greedy selection of the points: each new point is where the last basis
+  // vector is worst interpolated by the previous ones.
+  const unsigned int m = deim_basis.size();
+  deim_indices.clear();
+  deim_basis_at_points.reinit(m, m);
+
+  for (unsigned int l = 0; l < m; ++l) {
+    VectorType residual = deim_basis[l];
+
+    if (l > 0) {
+      FullMatrix<double> interpolation(l, l);
+      Vector<double> rhs(l);
+      Vector<double> coefficients(l);
+      for (unsigned int i = 0; i < l; ++i) {
+        for (unsigned int k = 0; k < l; ++k)
+          interpolation(i, k) = deim_basis_at_points(i, k);
+        rhs(i) = deim_basis_at_points(i, l);
+      }
+
+      interpolation.gauss_jordan();
+      interpolation.vmult(coefficients, rhs);
+
+      for (unsigned int k = 0; k < l; ++k)
+        residual.add(-coefficients(k), deim_basis[k]);
+    }
+
+    // Largest entry of the residual over all processes.
+    double local_max = -1.0;
+    types::global_dof_index local_index = 0;
+    for (const auto i : residual.locally_owned_elements())
+      if (std::abs(residual(i)) > local_max) {
+        local_max = std::abs(residual(i));
+        local_index = i;
+      }
+
+    const Utilities::MPI::MinMaxAvg max_entry =
+        Utilities::MPI::min_max_avg(local_max, MPI_COMM_WORLD);
+    const types::global_dof_index index = Utilities::MPI::sum(
+        mpi_rank == max_entry.max_index ? local_index
+                                        : types::global_dof_index(0),
+        MPI_COMM_WORLD);
+
+    deim_indices.push_back(index);
+
+    const std::vector<double> values = values_at(deim_basis, index);
+    for (unsigned int k = 0; k < m; ++k)
+      deim_basis_at_points(l, k) = values[k];
+  }
+
+  pcout << "  DEIM points                = " << deim_indices.size()
+        << std::endl;
+}
+
+void ReducedOrderModel::project_operators(
+    const MatrixType &mass,
+    const std::vector<const MatrixType *> &stiffness_terms,
+    const VectorType &u_0) {
+  TimerOutput::Scope t(timer, "ROM offline (projection)");
+
+  const unsigned int n = basis.size();
+  const unsigned int m = deim_basis.size();
+
+  VectorType tmp(basis.front());
+
+  // Projection of a matrix onto the POD basis.
+  const auto project = [&](const MatrixType &matrix,
+                           FullMatrix<double> &reduced) {
+    reduced.reinit(n, n);
+    for (unsigned int j = 0; j < n; ++j) {
+      matrix.vmult(tmp, basis[j]);
+      for (unsigned int i = 0; i < n; ++i)
+        reduced(i, j) = basis[i] * tmp;
+    }
+  };
+
+  project(mass, reduced_mass);
+
+  reduced_stiffness.resize(stiffness_terms.size());
+  for (unsigned int k = 0; k < stiffness_terms.size(); ++k)
+    project(*stiffness_terms[k], reduced_stiffness[k]);
+
+  // V^T M U (P^T U)^-1.
+  FullMatrix<double> mass_deim(n, m);
+  for (unsigned int k = 0; k < m; ++k) {
+    mass.vmult(tmp, deim_basis[k]);
+    for (unsigned int i = 0; i < n; ++i)
+      mass_deim(i, k) = basis[i] * tmp;
+  }
+
+  FullMatrix<double> deim_inverse(deim_basis_at_points);
+  deim_inverse.gauss_jordan();
+
+  reduced_deim.reinit(n, m);
+  mass_deim.mmult(reduced_deim, deim_inverse);
+
+  basis_at_points.reinit(m, n);
+  for (unsigned int i = 0; i < m; ++i) {
+    const std::vector<double> values = values_at(basis, deim_indices[i]);
+    for (unsigned int j = 0; j < n; ++j)
+      basis_at_points(i, j) = values[j];
+  }
+
+  // Total mass of the modes, V^T M 1.
+  VectorType ones(basis.front());
+  ones = 1.0;
+  mass.vmult(tmp, ones);
+
+  reduced_mass_functional.reinit(n);
+  for (unsigned int i = 0; i < n; ++i)
+    reduced_mass_functional(i) = basis[i] * tmp;
+
+  // The basis is M-orthonormal, so the coordinates of the initial condition
+  // are its M-products with the modes.
+  mass.vmult(tmp, u_0);
+
+  initial_coordinates.reinit(n);
+  for (unsigned int i = 0; i < n; ++i)
+    initial_coordinates(i) = basis[i] * tmp;
+}
+
+double ReducedOrderModel::solve(const std::vector<double> &stiffness_weights,
+                                const double alpha, const double T,
+                                const double deltat,
+                                const unsigned int max_newton_iterations,
+                                const double newton_tolerance,
+                                const std::string &output_file) {
+  TimerOutput::Scope t(timer, "ROM online solve");
+  Timer wall_timer;
+
+  const unsigned int n = basis.size();
+  const unsigned int m = deim_basis.size();
+
+  FullMatrix<double> reduced_stiffness_sum(n, n);
+  for (unsigned int k = 0; k < reduced_stiffness.size(); ++k)
+    reduced_stiffness_sum.add(stiffness_weights[k], reduced_stiffness[k]);
+
+  Vector<double> a(initial_coordinates);
+  Vector<double> a_old(n);
+  Vector<double> residual(n);
+  Vector<double> delta(n);
+  Vector<double> tmp(n);
+
+  // Solution and reaction term at the interpolation points.
+  Vector<double> u_points(m);
+  Vector<double> f_points(m);
+
+  FullMatrix<double> jacobian(n, n);
+  FullMatrix<double> reaction_jacobian(m, n);
+  FullMatrix<double> reduced_reaction_jacobian(n, n);
+
+  std::ofstream file;
+  if (mpi_rank == 0) {
+    file.open(output_file);
+    file << "step,time,mass,newton_iterations" << std::endl;
+    file << 0 << "," << 0.0 << "," << reduced_mass_functional * a << "," << 0
+         << std::endl;
+  }
+
+  double time = 0.0;
+  unsigned int time_step = 0;
+  unconverged_steps = 0;
+
+  while (time < T - 0.5 * deltat) {
+    time += deltat;
+    ++time_step;
+
+    a_old = a;
+
+    unsigned int n_iter = 0;
+    double residual_norm = newton_tolerance + 1;
+    while (true) {
+      basis_at_points.vmult(u_points, a);
+      for (unsigned int i = 0; i < m; ++i)
+        f_points(i) = u_points(i) * (1.0 - u_points(i));
+
+      // Residual of the reduced problem.
+      delta = a;
+      delta -= a_old;
+      reduced_mass.vmult(residual, delta);
+      residual *= 1.0 / deltat;
+      reduced_stiffness_sum.vmult_add(residual, a);
+      reduced_deim.vmult(tmp, f_points);
+      residual.add(-alpha, tmp);
+
+      // The residual is evaluated once more after the last update, so that
+      // the convergence check below sees the accepted iterate.
+      residual_norm = residual.l2_norm();
+      if (residual_norm <= newton_tolerance || n_iter == max_newton_iterations)
+        break;
+
+      // Jacobian of the reduced problem.
+      for (unsigned int i = 0; i < m; ++i)
+        for (unsigned int j = 0; j < n; ++j)
+          reaction_jacobian(i, j) =
+              (1.0 - 2.0 * u_points(i)) * basis_at_points(i, j);
+      reduced_deim.mmult(reduced_reaction_jacobian, reaction_jacobian);
+
+      jacobian = reduced_mass;
+      jacobian *= 1.0 / deltat;
+      jacobian.add(1.0, reduced_stiffness_sum);
+      jacobian.add(-alpha, reduced_reaction_jacobian);
+
+      jacobian.gauss_jordan();
+      jacobian.vmult(delta, residual);
+      a -= delta;
+
+      ++n_iter;
+    }
+
+    if (residual_norm > newton_tolerance) {
+      ++unconverged_steps;
+      pcout << "  Warning: Newton did not converge within "
+            << max_newton_iterations << " iterations at time step "
+            << time_step << " (residual = " << residual_norm << ")"
+            << std::endl;
+    }
+
+    if (mpi_rank == 0)
+      file << time_step << "," << time << "," << reduced_mass_functional * a
+           << "," << n_iter << std::endl;
+  }
+
+  wall_timer.stop();
+
+  return wall_timer.wall_time() / std::max(time_step, 1u);
+}
+
+std::vector<ReducedOrderModel::VectorType>
+ReducedOrderModel::pod(const std::vector<VectorType> &snapshots,
+                       const MatrixType *inner_matrix, const double tolerance,
+                       const unsigned int max_modes) const {
+  const unsigned int n_snapshots = snapshots.size();
+  AssertThrow(n_snapshots > 0, ExcMessage("No snapshots were collected."));
+
+  // Products of the snapshots with the matrix of the inner product.
+  std::vector<VectorType> weighted;
+  if (inner_matrix != nullptr) {
+    weighted.resize(n_snapshots);
+    for (unsigned int j = 0; j < n_snapshots; ++j) {
+      weighted[j].reinit(snapshots[j]);
+      inner_matrix->vmult(weighted[j], snapshots[j]);
+    }
+  }
+  const std::vector<VectorType> &weighted_snapshots =
+      inner_matrix != nullptr ? weighted : snapshots;
+
+  // Correlation matrix of the snapshots.
+  LAPACKFullMatrix<double> correlation(n_snapshots, n_snapshots);
+  double trace = 0.0;
+  for (unsigned int i = 0; i < n_snapshots; ++i) {
+    for (unsigned int j = 0; j <= i; ++j) {
+      const double product = snapshots[i] * weighted_snapshots[j];
+      correlation(i, j) = product;
+      correlation(j, i) = product;
+    }
+    trace += correlation(i, i);
+  }
+
+  AssertThrow(trace > 0.0, ExcMessage("The snapshots are all zero."));
+
+  // Eigenvalues in ascending order.
+  Vector<double> eigenvalues;
+  FullMatrix<double> eigenvectors;
+  correlation.compute_eigenvalues_symmetric(-trace, 2.0 * trace,
+                                            1e-14 * trace, eigenvalues,
+                                            eigenvectors);
+
+  // Most energetic modes first, until the captured energy is large enough.
+  std::vector<VectorType> modes;
+  double captured = 0.0;
+  for (int k = eigenvalues.size() - 1; k >= 0; --k) {
+    if (modes.size() >= max_modes || captured >= (1.0 - tolerance) * trace ||
+        eigenvalues(k) <= 1e-12 * trace)
+      break;
+
+    VectorType mode(snapshots.front());
+    mode = 0.0;
+    for (unsigned int j = 0; j < n_snapshots; ++j)
+      mode.add(eigenvectors(j, k) / std::sqrt(eigenvalues(k)), snapshots[j]);
+
+    modes.push_back(mode);
+    captured += eigenvalues(k);
+  }
+
+  return modes;
+}
+
+std::vector<double>
+ReducedOrderModel::values_at(const std::vector<VectorType> &vectors,
+                             const types::global_dof_index index) const {
+  std::vector<double> values(vectors.size(), 0.0);
+  if (vectors.front().locally_owned_elements().is_element(index))
+    for (unsigned int k = 0; k < vectors.size(); ++k)
+      values[k] = vectors[k](index);
+
+  std::vector<double> result(vectors.size());
+  Utilities::MPI::sum(values, MPI_COMM_WORLD, result);
+
+  return result;
+}
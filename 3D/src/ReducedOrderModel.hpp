@@ -0,0 +1,137 @@
+#ifndef REDUCED_ORDER_MODEL_HPP
+#define REDUCED_ORDER_MODEL_HPP
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/timer.h>
+
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/lapack_full_matrix.h>
+#include <deal.II/lac/trilinos_sparse_matrix.h>
+#include <deal.II/lac/trilinos_vector.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// Reduced-order model of the Fisher-Kolmogorov problem.
+//
+// Offline, the solution snapshots of full-order runs are compressed into a
+// POD basis V, orthonormal in the inner product of the mass matrix. The
+// reaction term is approximated as M f(u), with the nodal values
+// f(u) = u (1 - u) interpolated by DEIM from a few points of the mesh, so
+// that its reduced form only needs u at those points.
+//
+// Online, the projected problem
+//   V^T M V (a - a_old) / deltat + V^T K V a
+//     - alpha V^T M U (P^T U)^-1 f(P^T V a) = 0
+// is solved with Newton's method on the small dense system, whose size is
+// the number of POD modes. K depends linearly on Dext and Daxn, so each
+// term of the stiffness matrix is projected once, and the model can be
+// evaluated for any Dext, Daxn and alpha.
+class ReducedOrderModel {
+public:
+  using VectorType = TrilinosWrappers::MPI::Vector;
+  using MatrixType = TrilinosWrappers::SparseMatrix;
+
+  ReducedOrderModel(ConditionalOStream &pcout_in, TimerOutput &timer_in)
+      : mpi_rank(Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)),
+        pcout(pcout_in), timer(timer_in) {}
+
+  // Compute the POD basis of the snapshots, keeping the modes that capture
+  // a fraction 1 - tolerance of their energy, at most max_modes.
+  void compute_pod_basis(const std::vector<VectorType> &snapshots,
+                         const MatrixType &mass, const double tolerance,
+                         const unsigned int max_modes);
+
+  // Compute the DEIM basis and interpolation points of the reaction term,
+  // from its values at the snapshots.
+  void compute_deim(const std::vector<VectorType> &snapshots,
+                    const double tolerance, const unsigned int max_points);
+
+  // Project the mass matrix, the terms of the stiffness matrix and the
+  // initial condition onto the POD basis.
+  void project_operators(const MatrixType &mass,
+                         const std::vector<const MatrixType *> &stiffness_terms,
+                         const VectorType &u_0);
+
+  // Solve the reduced problem up to the final time, with the stiffness
+  // matrix sum_t stiffness_weights[t] K_t. The total mass of the solution at
+  // each time step is written to output_file. Returns the wall time per time
+  // step. Steps whose Newton residual is still above newton_tolerance after
+  // max_newton_iterations are kept, with a warning, and counted in
+  // n_unconverged_steps().
+  double solve(const std::vector<double> &stiffness_weights,
+               const double alpha, const double T, const double deltat,
+               const unsigned int max_newton_iterations,
+               const double newton_tolerance, const std::string &output_file);
+
+  unsigned int n_modes() const { return basis.size(); }
+
+  unsigned int n_deim_points() const { return deim_indices.size(); }
+
+  // Number of time steps of the last solve() whose Newton iterations did not
+  // converge.
+  unsigned int n_unconverged_steps() const { return unconverged_steps; }
+
+private:
+  // POD by the method of snapshots, in the inner product of inner_matrix (or
+  // the Euclidean one, if nullptr).
+  std::vector<VectorType> pod(const std::vector<VectorType> &snapshots,
+                              const MatrixType *inner_matrix,
+                              const double tolerance,
+                              const unsigned int max_modes) const;
+
+  // Entries of the vectors at a global index, on all processes.
+  std::vector<double> values_at(const std::vector<VectorType> &vectors,
+                                const types::global_dof_index index) const;
+
+  // This MPI process.
+  const unsigned int mpi_rank;
+
+  // Parallel output stream.
+  ConditionalOStream &pcout;
+
+  // Timer for the offline and online phases.
+  TimerOutput &timer;
+
+  // POD basis V.
+  std::vector<VectorType> basis;
+
+  // DEIM basis U of the reaction term.
+  std::vector<VectorType> deim_basis;
+
+  // DEIM interpolation points P (global DoF indices).
+  std::vector<types::global_dof_index> deim_indices;
+
+  // Values of the DEIM basis at the interpolation points, P^T U.
+  FullMatrix<double> deim_basis_at_points;
+
+  // Projected mass matrix V^T M V.
+  FullMatrix<double> reduced_mass;
+
+  // Projected terms of the stiffness matrix V^T K_t V.
+  std::vector<FullMatrix<double>> reduced_stiffness;
+
+  // Projected DEIM operator V^T M U (P^T U)^-1.
+  FullMatrix<double> reduced_deim;
+
+  // Values of the POD basis at the interpolation points, P^T V.
+  FullMatrix<double> basis_at_points;
+
+  // Unconverged time steps of the last solve().
+  unsigned int unconverged_steps = 0;
+
+  // Total mass of each mode, V^T M 1.
+  Vector<double> reduced_mass_functional;
+
+  // Coordinates of the initial condition.
+  Vector<double> initial_coordinates;
+};
+
+#endif
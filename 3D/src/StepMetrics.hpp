@@ -0,0 +1,60 @@
+#ifndef STEP_METRICS_HPP
+#define STEP_METRICS_HPP
+
+#include <chrono>
+
+// Wall times of the phases of a time step, on the current process, for the
+// per-step metrics stream.
+struct StepMetrics {
+  double assembly = 0.0;
+  double preconditioner_setup = 0.0;
+  double preconditioner_apply = 0.0;
+  double linear_solve = 0.0;
+  double ghost_exchange = 0.0;
+  double output = 0.0;
+};
+
+// Adds the wall time of its lifetime to a counter. With a null counter it
+// does nothing, not even read the clock, so that the metrics cost nothing
+// when they are off.
+class ScopedMetric {
+public:
+  explicit ScopedMetric(double *counter_) : counter(counter_) {
+    if (counter != nullptr)
+      start = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedMetric() {
+    if (counter != nullptr)
+      *counter += std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  }
+
+  ScopedMetric(const ScopedMetric &) = delete;
+  ScopedMetric &operator=(const ScopedMetric &) = delete;
+
+private:
+  double *counter;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Preconditioner that forwards to another one, timing its applications.
+template <typename PreconditionerType> class TimedPreconditioner {
+public:
+  TimedPreconditioner(const PreconditionerType &preconditioner_,
+                      double *counter_)
+      : preconditioner(preconditioner_), counter(counter_) {}
+
+  template <typename VectorType>
+  void vmult(VectorType &dst, const VectorType &src) const {
+    ScopedMetric metric(counter);
+    preconditioner.vmult(dst, src);
+  }
+
+private:
+  const PreconditionerType &preconditioner;
+  double *counter;
+};
+
+#endif
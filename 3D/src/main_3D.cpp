@@ -2,6 +2,73 @@
 #include "FisherKolmogorov3D.hpp"
 #include "ParameterReader.hpp"
 
+#include <deal.II/base/multithread_info.h>
+
+// Append the timings and iteration counts of a run to a CSV file, one row
+// per run. The phases are the totals of the timer sections, taking the
+// slowest process for each.
+void write_benchmark_record(const std::string &file_name,
+                            const SimulationParameters &params,
+                            const FisherKolmogorov3D &problem,
+                            const TimerOutput &timer) {
+  const std::map<std::string, double> wall_times =
+      timer.get_summary_data(TimerOutput::total_wall_time);
+
+  const auto phase_time = [&wall_times](const std::vector<std::string> &names) {
+    double time = 0.0;
+    for (const auto &name : names) {
+      const auto it = wall_times.find(name);
+      if (it != wall_times.end())
+        time += it->second;
+    }
+    return Utilities::MPI::max(time, MPI_COMM_WORLD);
+  };
+
+  const double setup = phase_time({"Setup"});
+  const double assemble =
+      phase_time({"Assemble system", "Assemble residual",
+                  "Assemble constant matrix", "Update active region"});
+  const double preconditioner = phase_time({"Setup preconditioner"});
+  const double cg = phase_time({"Solve linear system", "Solve linear step"});
+  const double output = phase_time({"Writing"});
+  const double solve = phase_time({"Time loop (solve)"});
+  const double matrix_free_memory = problem.matrix_free_memory();
+
+  if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) != 0)
+    return;
+
+  const bool new_file = !std::filesystem::exists(file_name);
+  std::ofstream file(file_name, std::ios::app);
+  AssertThrow(file.is_open(),
+              ExcMessage("Could not open the benchmark file " + file_name));
+
+  if (new_file)
+    file << "ranks,threads,mesh,element_type,degree,linear_solver,n_dofs,"
+            "time_steps,newton_iterations,cg_iterations,setup,assemble,"
+            "preconditioner_setup,cg,output,solve,dofs_per_second,"
+            "cg_iterations_per_step,operator_cache_hits,"
+            "operator_cache_misses,matrix_free_memory_mb"
+         << std::endl;
+
+  const unsigned int time_steps = std::max(problem.n_time_steps(), 1u);
+
+  file << Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD) << ","
+       << MultithreadInfo::n_threads() << "," << params.mesh_file << ","
+       << params.element_type << "," << params.r << ","
+       << params.linear_solver << "," << problem.n_dofs() << ","
+       << problem.n_time_steps() << ","
+       << problem.n_newton_iterations() << "," << problem.n_cg_iterations()
+       << "," << setup << "," << assemble << "," << preconditioner << ","
+       << cg << "," << output << "," << solve << ","
+       << problem.n_dofs() * static_cast<double>(time_steps) /
+              std::max(solve, 1e-12)
+       << ","
+       << static_cast<double>(problem.n_cg_iterations()) / time_steps << ","
+       << problem.n_operator_cache_hits() << ","
+       << problem.n_operator_cache_misses() << "," << matrix_free_memory
+       << std::endl;
+}
+
 // Main function.
 int main(int argc, char *argv[]) {
   Utilities::MPI::MPI_InitFinalize mpi_init(argc, argv);
@@ -56,16 +123,116 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  const std::string mesh_file = "../mesh/brain-h3.0.msh";
+  // Threads used by the cell assembly of each MPI process.
+  if (params.n_threads > 0)
+    MultithreadInfo::set_thread_limit(params.n_threads);
+  pcout << "Threads per MPI process = " << MultithreadInfo::n_threads()
+        << std::endl;
 
-  FisherKolmogorov3D problem(mesh_file, *params.diffusion_tensor, params.alpha,
+  FisherKolmogorov3D problem(params.mesh_file, *params.diffusion_tensor, params.alpha,
                              params.r, params.T, params.deltat, pcout, timer);
 
+  problem.set_mesh_parameters(params.mesh_loading, params.mesh_group_size,
+                              params.mesh_cache, params.mesh_cache_directory);
+  problem.set_element_type(params.element_type);
+  problem.set_partitioning_parameters(params.partitioner,
+                                      params.seed_cell_weight,
+                                      params.dof_renumbering);
+  problem.set_refinement_parameters(
+      params.adaptive_refinement, params.refinement_interval,
+      params.refinement_indicator, params.refine_fraction,
+      params.coarsen_fraction, params.max_refinement_level,
+      params.initial_refinement_cycles);
+  problem.set_rebalancing_parameters(params.rebalance_interval,
+                                     params.rebalance_cost,
+                                     params.rebalance_threshold);
   problem.set_solver_parameters(
       params.max_newton_iterations, params.newton_tolerance,
       params.max_cg_iterations, params.cg_tolerance_factor);
+  problem.set_linear_solver(params.linear_solver);
+  problem.set_matrix_free(params.matrix_free, params.mixed_precision);
+  problem.set_assembly_parameters(params.split_assembly,
+                                  params.lumped_reaction);
+  problem.set_active_region_parameters(
+      params.active_region_assembly, params.active_region_tolerance,
+      params.active_region_halo, params.active_cell_weight);
+  problem.set_communication_overlap(params.communication_overlap);
+  problem.set_time_integrator(params.time_integrator, params.theta,
+                              params.time_scheme);
+  problem.set_predictor(params.predictor);
+  problem.set_newton_parameters(
+      params.inexact_newton, params.forcing_gamma, params.forcing_exponent,
+      params.max_forcing_term, params.jacobian_reuse,
+      params.jacobian_reuse_threshold);
+  problem.set_preconditioner_parameters(
+      params.preconditioner, params.preconditioner_rebuild_interval,
+      params.amg_smoother_type, params.amg_smoother_sweeps,
+      params.amg_aggregation_threshold);
+  problem.set_operator_cache(params.operator_cache_threshold);
+  problem.set_output_parameters(
+      params.output_format, params.output_interval, params.output_time_interval,
+      params.write_partitioning, params.asynchronous_output);
+  problem.set_metrics_parameters(params.metrics_file, params.metrics_format);
+  problem.set_adaptive_time_stepping(
+      params.adaptive_time_stepping, params.deltat_min, params.deltat_max,
+      params.target_newton_iterations, params.target_cg_iterations,
+      params.deltat_growth_factor);
+  problem.set_checkpoint_parameters(params.checkpoint_interval,
+                                    params.checkpoint_directory,
+                                    params.restart);
   problem.setup();
-  problem.solve();
+
+  if (!params.ensemble) {
+    problem.solve();
+
+    if (!params.benchmark_file.empty())
+      write_benchmark_record(params.benchmark_file, params, problem, timer);
+    return 0;
+  }
+
+  // Ensemble mode: the mesh, the DoF handler and the sparsity pattern set up
+  // above are shared by all the runs of the sweep.
+  AssertThrow(!params.adaptive_refinement && !params.restart,
+              ExcMessage("The ensemble mode does not support adaptive "
+                         "refinement or restarts."));
+
+  const std::vector<SimulationParameters> members =
+      parameter_reader.ensemble_members(params);
+
+  // Index of the runs, with the parameters of each output series.
+  std::ofstream ensemble_file;
+  if (mpi_rank == 0) {
+    ensemble_file.open("ensemble.csv");
+    ensemble_file << "member,output,tensor,dext,daxn,alpha" << std::endl;
+  }
+
+  for (unsigned int m = 0; m < members.size(); ++m) {
+    const SimulationParameters &member = members[m];
+    const std::string output_name = "output_m" + Utilities::int_to_string(m, 3);
+
+    pcout << "===============================================" << std::endl;
+    pcout << "Ensemble member " << m + 1 << "/" << members.size() << ": "
+          << member.diffusion_tensor_type << ", Dext = " << member.dext
+          << ", Daxn = " << member.daxn << ", alpha = " << member.alpha
+          << std::endl;
+
+    if (mpi_rank == 0)
+      ensemble_file << m << "," << output_name << ","
+                    << member.diffusion_tensor_type << "," << member.dext
+                    << "," << member.daxn << "," << member.alpha << std::endl;
+
+    problem.set_problem_coefficients(member.diffusion_tensor, member.alpha);
+    problem.set_output_name(output_name);
+    // Each member checkpoints into its own directory, so that the members
+    // do not overwrite the checkpoints of each other.
+    if (params.checkpoint_interval > 0)
+      problem.set_checkpoint_parameters(
+          params.checkpoint_interval,
+          (std::filesystem::path(params.checkpoint_directory) / output_name)
+              .string(),
+          false);
+    problem.solve();
+  }
 
   return 0;
 }
\ No newline at end of file
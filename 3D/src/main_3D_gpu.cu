@@ -0,0 +1,156 @@
+#include "FisherKolmogorov3DGPU.hpp"
+#include "ParameterReader.hpp"
+
+// The GPU solver has its own time loop: backward Euler steps solved by
+// Newton's method with unpreconditioned CG on the matrix-free operator. It
+// does not go through the hooks of the FisherKolmogorov template, so the
+// options of the CPU solver that would change the scheme, the Newton
+// iteration or the files written are rejected instead of ignored.
+void check_gpu_options(const SimulationParameters &params) {
+  AssertThrow(params.matrix_free,
+              ExcMessage("The GPU solver is matrix-free: set Jacobian "
+                         "operator = Matrix-free (Preconditioner and the "
+                         "other matrix-based options do not apply)."));
+  AssertThrow(params.time_integrator == "Newton",
+              ExcMessage("The GPU solver only supports the Newton time "
+                         "integrator."));
+  AssertThrow(params.time_scheme == "Theta" && params.theta == 1.0,
+              ExcMessage("The GPU solver only supports backward Euler "
+                         "(Time scheme = Theta, Theta = 1)."));
+  AssertThrow(!params.adaptive_time_stepping,
+              ExcMessage("The GPU solver does not support adaptive time "
+                         "stepping."));
+  AssertThrow(params.predictor == "None",
+              ExcMessage("The GPU solver does not support a Predictor."));
+  AssertThrow(!params.inexact_newton && !params.jacobian_reuse,
+              ExcMessage("The GPU solver does not support inexact Newton or "
+                         "Jacobian reuse."));
+  AssertThrow(params.linear_solver == "CG" && !params.mixed_precision,
+              ExcMessage("The GPU solver only supports double-precision "
+                         "CG."));
+  AssertThrow(params.element_type == "Hexahedra" &&
+                  !params.adaptive_refinement && params.rebalance_interval == 0,
+              ExcMessage("The GPU solver always splits the mesh into "
+                         "hexahedra (Element type = Hexahedra), without "
+                         "adaptive refinement or rebalancing."));
+  AssertThrow(params.output_format == "VTU" &&
+                  params.output_time_interval == 0.0 &&
+                  !params.asynchronous_output,
+              ExcMessage("The GPU solver only writes synchronous VTU output "
+                         "every Output interval time steps."));
+  AssertThrow(params.checkpoint_interval == 0 && !params.restart,
+              ExcMessage("The GPU solver does not support checkpoints or "
+                         "restarts."));
+  AssertThrow(!params.ensemble,
+              ExcMessage("The GPU solver does not support the ensemble "
+                         "mode."));
+}
+
+// Run the problem on the GPU, with the polynomial degree as a template
+// argument of the CUDA kernels.
+template <int fe_degree>
+void run(const SimulationParameters &params, ConditionalOStream &pcout,
+         TimerOutput &timer) {
+  DiffusionTensorData tensor;
+  tensor.type =
+      DiffusionTensorData::type_from_string(params.diffusion_tensor_type);
+  tensor.dext = params.dext;
+  tensor.daxn =
+      tensor.type == DiffusionTensorData::Type::isotropic ? 0.0 : params.daxn;
+  for (unsigned int i = 0; i < 3; ++i)
+    tensor.center[i] = params.tensor_center[i];
+
+  FisherKolmogorov3DGPU<fe_degree> problem(params.mesh_file, tensor,
+                                           params.alpha, params.T,
+                                           params.deltat, pcout, timer);
+
+  problem.set_solver_parameters(
+      params.max_newton_iterations, params.newton_tolerance,
+      params.max_cg_iterations, params.cg_tolerance_factor);
+  problem.set_output_interval(params.output_interval);
+  problem.setup();
+  problem.solve();
+}
+
+// Main function.
+int main(int argc, char *argv[]) {
+  Utilities::MPI::MPI_InitFinalize mpi_init(argc, argv, 1);
+  const unsigned int mpi_rank =
+      Utilities::MPI::this_mpi_process(MPI_COMM_WORLD);
+
+  // Stream for std::cout output:
+  ConditionalOStream pcout(std::cout, mpi_rank == 0);
+
+  // Each process uses one of the GPUs of its node.
+  int n_devices = 0;
+  cudaError_t cuda_error_code = cudaGetDeviceCount(&n_devices);
+  AssertCuda(cuda_error_code);
+  const int device_id = mpi_rank % n_devices;
+  cuda_error_code = cudaSetDevice(device_id);
+  AssertCuda(cuda_error_code);
+
+  //Build an ofstream for writing the timer summary:
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD);
+  std::ostringstream fname;
+  fname << "timer_summary_gpu_np" << n_procs << ".txt";
+  std::ofstream timer_file(fname.str());
+  if (mpi_rank == 0 && !timer_file.is_open())
+  {
+    std::cerr << "ERROR: could not open '" << fname.str()
+              << "' for writing\n";
+    return 1;
+  }
+
+  // Build a ConditionalOStream for the timer output:
+  ConditionalOStream timer_stream(timer_file, mpi_rank == 0);
+
+  // Create a TimerOutput object to manage the timing of the program.
+  TimerOutput timer(MPI_COMM_WORLD,
+                    timer_stream,
+                    TimerOutput::summary,
+                    TimerOutput::wall_times);
+
+  // Read parameters
+  ParameterHandler prm;
+  SimulationParameters params;
+  ParameterReader parameter_reader(prm);
+
+  std::string parameter_file = "../build/parameters.prm"; // Default value
+  if (argc > 1) {
+    parameter_file = argv[1]; // Use command line argument if provided
+  } else {
+    if (mpi_rank == 0) {
+      std::cout << "Usage: " << argv[0] << " <parameter_file>" << std::endl;
+      std::cout << "No parameter file specified, using default: "
+                << parameter_file << std::endl;
+    }
+  }
+
+  try {
+    params = parameter_reader.read_parameters(parameter_file);
+  } catch (const std::exception &e) {
+    if (mpi_rank == 0)
+      std::cerr << "Error reading parameter file: " << e.what() << std::endl;
+    return 1;
+  }
+
+  pcout << "GPU devices per node = " << n_devices << std::endl;
+
+  check_gpu_options(params);
+
+  switch (params.r) {
+  case 1:
+    run<1>(params, pcout, timer);
+    break;
+  case 2:
+    run<2>(params, pcout, timer);
+    break;
+  case 3:
+    run<3>(params, pcout, timer);
+    break;
+  default:
+    AssertThrow(false, ExcMessage("The GPU solver supports degrees 1 to 3."));
+  }
+
+  return 0;
+}
@@ -0,0 +1,279 @@
+#include "DiffusionTensor.hpp"
+#include "FisherKolmogorov3D.hpp"
+#include "ParameterReader.hpp"
+#include "ReducedOrderModel.hpp"
+
+#include <deal.II/base/multithread_info.h>
+
+// Main function of the reduced-order model: the full-order runs of the
+// ensemble are the training set, and the reduced model is then run for the
+// online parameters.
+int main(int argc, char *argv[]) {
+  Utilities::MPI::MPI_InitFinalize mpi_init(argc, argv);
+  const unsigned int mpi_rank =
+      Utilities::MPI::this_mpi_process(MPI_COMM_WORLD);
+
+  // Stream for std::cout output:
+  ConditionalOStream pcout(std::cout, mpi_rank == 0);
+
+  //Build an ofstream for writing the timer summary:
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD);
+  std::ostringstream fname;
+  fname << "timer_summary_rom_np" << n_procs << ".txt";
+  std::ofstream timer_file(fname.str());
+  if (mpi_rank == 0 && !timer_file.is_open())
+  {
+    std::cerr << "ERROR: could not open '" << fname.str() 
+              << "' for writing\n";
+    return 1;
+  }
+
+  // Build a ConditionalOStream for the timer output:
+  ConditionalOStream timer_stream(timer_file, mpi_rank == 0);
+
+  // Create a TimerOutput object to manage the timing of the program.
+  TimerOutput timer(MPI_COMM_WORLD,
+                    timer_stream,
+                    TimerOutput::summary,
+                    TimerOutput::wall_times);
+
+  // Read parameters
+  ParameterHandler prm;
+  SimulationParameters params;
+  ParameterReader parameter_reader(prm);
+
+  std::string parameter_file = "../build/parameters.prm"; // Default value
+  if (argc > 1) {
+    parameter_file = argv[1]; // Use command line argument if provided
+  } else {
+    if (mpi_rank == 0) {
+      std::cout << "Usage: " << argv[0] << " <parameter_file>" << std::endl;
+      std::cout << "No parameter file specified, using default: "
+                << parameter_file << std::endl;
+    }
+  }
+
+  try {
+    params = parameter_reader.read_parameters(parameter_file);
+  } catch (const std::exception &e) {
+    if (mpi_rank == 0)
+      std::cerr << "Error reading parameter file: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // Threads used by the cell assembly of each MPI process.
+  if (params.n_threads > 0)
+    MultithreadInfo::set_thread_limit(params.n_threads);
+  pcout << "Threads per MPI process = " << MultithreadInfo::n_threads()
+        << std::endl;
+
+  FisherKolmogorov3D problem(params.mesh_file, *params.diffusion_tensor, params.alpha,
+                             params.r, params.T, params.deltat, pcout, timer);
+
+  problem.set_mesh_parameters(params.mesh_loading, params.mesh_group_size,
+                              params.mesh_cache, params.mesh_cache_directory);
+  problem.set_element_type(params.element_type);
+  problem.set_partitioning_parameters(params.partitioner,
+                                      params.seed_cell_weight,
+                                      params.dof_renumbering);
+  problem.set_refinement_parameters(
+      params.adaptive_refinement, params.refinement_interval,
+      params.refinement_indicator, params.refine_fraction,
+      params.coarsen_fraction, params.max_refinement_level,
+      params.initial_refinement_cycles);
+  problem.set_rebalancing_parameters(params.rebalance_interval,
+                                     params.rebalance_cost,
+                                     params.rebalance_threshold);
+  problem.set_solver_parameters(
+      params.max_newton_iterations, params.newton_tolerance,
+      params.max_cg_iterations, params.cg_tolerance_factor);
+  problem.set_linear_solver(params.linear_solver);
+  problem.set_matrix_free(params.matrix_free, params.mixed_precision);
+  problem.set_assembly_parameters(params.split_assembly,
+                                  params.lumped_reaction);
+  problem.set_active_region_parameters(
+      params.active_region_assembly, params.active_region_tolerance,
+      params.active_region_halo, params.active_cell_weight);
+  problem.set_communication_overlap(params.communication_overlap);
+  problem.set_time_integrator(params.time_integrator, params.theta,
+                              params.time_scheme);
+  problem.set_predictor(params.predictor);
+  problem.set_newton_parameters(
+      params.inexact_newton, params.forcing_gamma, params.forcing_exponent,
+      params.max_forcing_term, params.jacobian_reuse,
+      params.jacobian_reuse_threshold);
+  problem.set_preconditioner_parameters(
+      params.preconditioner, params.preconditioner_rebuild_interval,
+      params.amg_smoother_type, params.amg_smoother_sweeps,
+      params.amg_aggregation_threshold);
+  problem.set_operator_cache(params.operator_cache_threshold);
+  problem.set_output_parameters(
+      params.output_format, params.output_interval, params.output_time_interval,
+      params.write_partitioning, params.asynchronous_output);
+  problem.set_metrics_parameters(params.metrics_file, params.metrics_format);
+  problem.set_adaptive_time_stepping(
+      params.adaptive_time_stepping, params.deltat_min, params.deltat_max,
+      params.target_newton_iterations, params.target_cg_iterations,
+      params.deltat_growth_factor);
+  problem.set_checkpoint_parameters(params.checkpoint_interval,
+                                    params.checkpoint_directory,
+                                    params.restart);
+  problem.set_snapshot_interval(params.snapshot_interval);
+
+  // The projection needs the assembled mass and stiffness matrices. Check
+  // it here rather than after all the training runs.
+  AssertThrow(!params.restart,
+              ExcMessage("The reduced-order model does not support restarts."));
+  AssertThrow(!params.matrix_free,
+              ExcMessage("The reduced-order model requires the matrix-based "
+                         "Jacobian operator (Jacobian operator = "
+                         "Matrix-based)."));
+  // The online stage is a backward Euler scheme with the fixed time step, so
+  // the training runs must use the same discretization.
+  AssertThrow(params.time_integrator == "Newton" &&
+                  params.time_scheme == "Theta" && params.theta == 1.0,
+              ExcMessage("The reduced-order model requires the backward Euler "
+                         "scheme (Time integrator = Newton, Time scheme = "
+                         "Theta, Theta = 1.0)."));
+  AssertThrow(!params.adaptive_time_stepping,
+              ExcMessage("The reduced-order model does not support adaptive "
+                         "time stepping."));
+
+  problem.setup();
+
+  // Offline stage: full-order training runs.
+  const std::vector<SimulationParameters> training =
+      parameter_reader.ensemble_members(params);
+
+  // Each run keeps only its own snapshots: the training set collects them.
+  std::vector<TrilinosWrappers::MPI::Vector> snapshots;
+
+  for (unsigned int m = 0; m < training.size(); ++m) {
+    const SimulationParameters &member = training[m];
+
+    pcout << "===============================================" << std::endl;
+    pcout << "Training run " << m + 1 << "/" << training.size() << ": "
+          << member.diffusion_tensor_type << ", Dext = " << member.dext
+          << ", Daxn = " << member.daxn << ", alpha = " << member.alpha
+          << std::endl;
+
+    problem.set_problem_coefficients(member.diffusion_tensor, member.alpha);
+    const std::string output_name =
+        "output_train_m" + Utilities::int_to_string(m, 3);
+    problem.set_output_name(output_name);
+    // As in the ensemble, each run checkpoints into its own directory.
+    if (params.checkpoint_interval > 0)
+      problem.set_checkpoint_parameters(
+          params.checkpoint_interval,
+          (std::filesystem::path(params.checkpoint_directory) / output_name)
+              .string(),
+          false);
+    problem.solve();
+
+    snapshots.insert(snapshots.end(), problem.get_snapshots().begin(),
+                     problem.get_snapshots().end());
+  }
+
+  pcout << "===============================================" << std::endl;
+  pcout << "Building the reduced-order model" << std::endl;
+
+  // The stiffness matrix is Dext K_0 + Daxn K_f, where K_0 is the stiffness
+  // of the unit isotropic tensor and K_f that of the fiber term of the
+  // tensor type. Both are assembled with the existing assembly. The term of
+  // the fiber field is only there if a field is given. The problem shares the
+  // ownership of the terms, since it keeps the last one.
+  const Point<2> cir_center = {params.tensor_center[1],
+                               params.tensor_center[2]};
+  const auto isotropic_term = std::make_shared<IsotropicDiffusionTensor<3>>(1.0);
+  const auto radial_term = std::make_shared<RadialDiffusionTensor<3>>(
+      0.0, 1.0, params.tensor_center);
+  const auto circumferential_term =
+      std::make_shared<CircumferentialDiffusionTensor<3>>(0.0, 1.0,
+                                                          cir_center);
+
+  TrilinosWrappers::SparseMatrix mass;
+  TrilinosWrappers::SparseMatrix isotropic_stiffness;
+  TrilinosWrappers::SparseMatrix radial_stiffness;
+  TrilinosWrappers::SparseMatrix circumferential_stiffness;
+  TrilinosWrappers::SparseMatrix fiber_field_stiffness;
+
+  problem.set_problem_coefficients(isotropic_term, params.alpha);
+  problem.assemble_mass_and_stiffness(mass, isotropic_stiffness);
+  problem.set_problem_coefficients(radial_term, params.alpha);
+  problem.assemble_mass_and_stiffness(mass, radial_stiffness);
+  problem.set_problem_coefficients(circumferential_term, params.alpha);
+  problem.assemble_mass_and_stiffness(mass, circumferential_stiffness);
+
+  std::vector<const TrilinosWrappers::SparseMatrix *> stiffness_terms = {
+      &isotropic_stiffness, &radial_stiffness, &circumferential_stiffness};
+  if (params.fiber_field) {
+    const auto fiber_field_term =
+        std::make_shared<FiberFieldDiffusionTensor<3>>(0.0, 1.0,
+                                                       params.fiber_field);
+    problem.set_problem_coefficients(fiber_field_term, params.alpha);
+    problem.assemble_mass_and_stiffness(mass, fiber_field_stiffness);
+    stiffness_terms.push_back(&fiber_field_stiffness);
+  }
+
+  TrilinosWrappers::MPI::Vector u_0;
+  problem.interpolate_initial_condition(u_0);
+
+  ReducedOrderModel rom(pcout, timer);
+  rom.compute_pod_basis(snapshots, mass, params.pod_tolerance,
+                        params.max_pod_modes);
+  rom.compute_deim(snapshots, params.deim_tolerance, params.max_deim_points);
+  rom.project_operators(mass, stiffness_terms, u_0);
+
+  // Online stage: the same expansion as the ensemble, on the online lists.
+  SimulationParameters online_params = params;
+  online_params.ensemble_dext = params.online_dext;
+  online_params.ensemble_daxn = params.online_daxn;
+  online_params.ensemble_alpha = params.online_alpha;
+  online_params.ensemble_tensor_types = params.online_tensor_types;
+
+  const std::vector<SimulationParameters> online =
+      parameter_reader.ensemble_members(online_params);
+
+  std::ofstream online_file;
+  if (mpi_rank == 0) {
+    online_file.open("rom_runs.csv");
+    online_file << "run,output,tensor,dext,daxn,alpha,seconds_per_step,"
+                   "unconverged_steps"
+                << std::endl;
+  }
+
+  for (unsigned int m = 0; m < online.size(); ++m) {
+    const SimulationParameters &member = online[m];
+    const std::string output_name =
+        "rom_m" + Utilities::int_to_string(m, 3) + ".csv";
+
+    const double daxn =
+        member.diffusion_tensor_type == "Isotropic" ? 0.0 : member.daxn;
+    std::vector<double> weights = {
+        member.dext, member.diffusion_tensor_type == "Radial" ? daxn : 0.0,
+        member.diffusion_tensor_type == "Circumferential" ? daxn : 0.0};
+    if (params.fiber_field)
+      weights.push_back(member.diffusion_tensor_type == "Fiber field" ? daxn
+                                                                      : 0.0);
+
+    const double seconds_per_step =
+        rom.solve(weights, member.alpha, params.T, params.deltat,
+                  params.max_newton_iterations, params.newton_tolerance,
+                  output_name);
+
+    pcout << "Reduced run " << m + 1 << "/" << online.size() << ": "
+          << member.diffusion_tensor_type << ", Dext = " << member.dext
+          << ", Daxn = " << member.daxn << ", alpha = " << member.alpha
+          << " - " << std::scientific << seconds_per_step
+          << " s per time step" << std::defaultfloat << std::endl;
+
+    if (mpi_rank == 0)
+      online_file << m << "," << output_name << ","
+                  << member.diffusion_tensor_type << "," << member.dext << ","
+                  << member.daxn << "," << member.alpha << ","
+                  << seconds_per_step << "," << rom.n_unconverged_steps()
+                  << std::endl;
+  }
+
+  return 0;
+}
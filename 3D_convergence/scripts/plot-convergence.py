@@ -8,31 +8,35 @@ convergence_data = pd.read_csv(sys.argv[1], sep = ",")
 
 plt.rcParams.update({"font.size": 14})
 
-plt.plot(convergence_data.h,
+# Error vs. h (convergence.csv) or vs. deltat (time_convergence.csv).
+step = "deltat" if "deltat" in convergence_data.columns else "h"
+x = convergence_data[step]
+
+plt.plot(x,
          convergence_data.eL2,
          marker = 'o',
          label = 'L2')
-plt.plot(convergence_data.h,
+plt.plot(x,
          convergence_data.eH1,
          marker = 'o',
          label = 'H1')
-plt.plot(convergence_data.h,
-         convergence_data.h,
+plt.plot(x,
+         x,
          '--',
-         label = 'h')
-plt.plot(convergence_data.h,
-         convergence_data.h**2,
+         label = step)
+plt.plot(x,
+         x**2,
          '--',
-         label = 'h^2')
-plt.plot(convergence_data.h,
-         convergence_data.h**3,
+         label = step + '^2')
+plt.plot(x,
+         x**3,
          '--',
-         label = 'h^3')
+         label = step + '^3')
 
 plt.xscale("log")
 plt.yscale("log")
-plt.xlabel("h")
+plt.xlabel(step)
 plt.ylabel("error")
 plt.legend()
 
-plt.savefig("convergence.pdf")
\ No newline at end of file
+plt.savefig("convergence.pdf" if step == "h" else "time_convergence.pdf")
\ No newline at end of file
@@ -1,30 +1,18 @@
 #ifndef HEAT_NON_LINEAR_HPP
 #define HEAT_NON_LINEAR_HPP
 
-#include <deal.II/base/conditional_ostream.h>
-#include <deal.II/base/quadrature_lib.h>
-
-#include <deal.II/distributed/fully_distributed_tria.h>
+#include "FisherKolmogorov.hpp"
 
-#include <deal.II/dofs/dof_handler.h>
-#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/quadrature_lib.h>
 
 #include <deal.II/fe/fe_simplex_p.h>
-#include <deal.II/fe/fe_system.h>
-#include <deal.II/fe/fe_values.h>
-#include <deal.II/fe/fe_values_extractors.h>
 #include <deal.II/fe/mapping_fe.h>
 
 #include <deal.II/grid/grid_in.h>
 #include <deal.II/grid/grid_tools.h>
 
-#include <deal.II/lac/solver_cg.h>
-#include <deal.II/lac/trilinos_precondition.h>
-#include <deal.II/lac/trilinos_sparse_matrix.h>
-
-#include <deal.II/base/tensor_function.h>
 #include <deal.II/numerics/data_out.h>
-#include <deal.II/numerics/matrix_tools.h>
 #include <deal.II/numerics/vector_tools.h>
 
 #include <fstream>
@@ -32,45 +20,16 @@
 
 using namespace dealii;
 
-// Class representing the non-linear diffusion problem.
-class FisherKolmogorov3D {
+// Class representing the non-linear diffusion problem on a tetrahedral mesh,
+// with isotropic diffusion and the forcing term of the manufactured solution.
+// The assembly, the Newton method and the time loop are those of
+// FisherKolmogorov, on Trilinos linear algebra.
+class FisherKolmogorov3D
+    : public FisherKolmogorov<3, TrilinosLinearAlgebra> {
 public:
   // Physical dimension (1D, 2D, 3D)
   static constexpr unsigned int dim = 3;
 
-  // Function for the d coefficient.
-  class FunctionD : public TensorFunction<2, dim> {
-  public:
-    FunctionD(const double dext_value) : dext(dext_value) {}
-
-    virtual Tensor<2, dim> value(const Point<dim> & /*p*/) const override {
-      Tensor<2, dim> result;
-
-      for (unsigned int i = 0; i < dim; ++i) {
-        result[i][i] += dext;
-
-        for (unsigned int j = 0; j < dim; ++j)
-          result[i][j] += 0.0; // daxn * n * n;
-      }
-
-      return result;
-    }
-
-  private:
-    const double dext;
-  };
-
-  // Function for the forcing term.
-  class ForcingTerm : public Function<dim> {
-  public:
-    virtual double value(const Point<dim> &p,
-                         const unsigned int /*component*/ = 0) const override {
-      double ex_s = std::cos(M_PI * p[0]) * std::cos(M_PI * p[1]) *
-                    std::cos(M_PI * p[2]) * std::exp(-get_time());
-      return (3 * M_PI * M_PI - 1) * ex_s - 0.1 * ex_s * (1 - ex_s);
-    }
-  };
-
   // Function for initial conditions.
   class FunctionU0 : public Function<dim> {
   public:
@@ -117,38 +76,37 @@ public:
                      const double dext_value, const double alpha_,
                      const unsigned int &r_, const double &T_,
                      const double &deltat_)
-      : mpi_size(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD)),
+      : FisherKolmogorov(r_, T_, deltat_, alpha_),
+        mpi_size(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD)),
         mpi_rank(Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)),
-        pcout(std::cout, mpi_rank == 0), d(dext_value), alpha(alpha_), T(T_),
-        mesh_file_name(mesh_file_name_), r(r_), deltat(deltat_),
-        mesh(MPI_COMM_WORLD) {}
-
-  // Set the parameters for the Newton method and CG solver.
-  void set_solver_parameters(const unsigned int max_newton_iter,
-                             const double newton_tol,
-                             const unsigned int max_cg_iter,
-                             const double cg_tol_factor);
+        dext(dext_value), mesh_file_name(mesh_file_name_) {}
 
-  // Initialization.
-  void setup();
-
-  // Solve the problem.
-  void solve();
+  // In the time convergence study the problem starts from the exact
+  // solution, and no output is written.
+  void set_time_convergence_mode(const bool enabled);
 
   double compute_error(const VectorTools::NormType &norm_type);
 
+  // Norm of the difference from the solution of another problem on the same
+  // mesh, with the same degree and number of processes (hence the same DoF
+  // numbering), e.g. one with a smaller time step.
+  double compute_difference(const FisherKolmogorov3D &other,
+                            const VectorTools::NormType &norm_type);
+
 protected:
-  // Assemble the tangent problem.
-  void assemble_system();
+  void create_mesh() override;
+
+  void create_finite_element() override;
 
-  // Solve the linear system associated to the tangent problem.
-  void solve_linear_system();
+  SymmetricTensor<2, dim> diffusion_tensor(const Point<dim> &p) const override;
 
-  // Solve the problem for one time step using Newton's method.
-  void solve_newton();
+  bool has_forcing_term() const override { return true; }
 
-  // Output.
-  void output(const unsigned int &time_step) const;
+  double forcing_term(const Point<dim> &p, const double t) const override;
+
+  void initial_condition(TrilinosWrappers::MPI::Vector &u_0_owned) override;
+
+  void output(const unsigned int &time_step) override;
 
   // MPI parallel. /////////////////////////////////////////////////////////////
 
@@ -158,19 +116,10 @@ protected:
   // This MPI process.
   const unsigned int mpi_rank;
 
-  // Parallel output stream.
-  ConditionalOStream pcout;
-
   // Problem definition. ///////////////////////////////////////////////////////
 
-  // d coefficient.
-  FunctionD d;
-
-  // alpha coefficient.
-  const double alpha;
-
-  // Forcing term.
-  ForcingTerm forcing_term;
+  // Isotropic diffusion coefficient.
+  const double dext;
 
   // Initial conditions.
   FunctionU0 u_0;
@@ -178,70 +127,13 @@ protected:
   // Exact solution.
   ExactSolution exact_solution;
 
-  // Current time.
-  double time;
-
-  // Final time.
-  const double T;
-
-  // Maximum number of Newton iterations.
-  unsigned int max_newton_iterations;
-
-  // Newton tolerance.
-  double newton_tolerance;
-
-  // Max CG iteration
-  unsigned int max_cg_iterations;
-
-  // CG tolerance factor.
-  double cg_tolerance_factor;
-
   // Discretization. ///////////////////////////////////////////////////////////
 
   // Mesh file name.
   const std::string mesh_file_name;
 
-  // Polynomial degree.
-  const unsigned int r;
-
-  // Time step.
-  const double deltat;
-
-  // Mesh.
-  parallel::fullydistributed::Triangulation<dim> mesh;
-
-  // Finite element space.
-  std::unique_ptr<FiniteElement<dim>> fe;
-
-  // Quadrature formula.
-  std::unique_ptr<Quadrature<dim>> quadrature;
-
-  // DoF handler.
-  DoFHandler<dim> dof_handler;
-
-  // DoFs owned by current process.
-  IndexSet locally_owned_dofs;
-
-  // DoFs relevant to the current process (including ghost DoFs).
-  IndexSet locally_relevant_dofs;
-
-  // Jacobian matrix.
-  TrilinosWrappers::SparseMatrix jacobian_matrix;
-
-  // Residual vector.
-  TrilinosWrappers::MPI::Vector residual_vector;
-
-  // Increment of the solution between Newton iterations.
-  TrilinosWrappers::MPI::Vector delta_owned;
-
-  // System solution (without ghost elements).
-  TrilinosWrappers::MPI::Vector solution_owned;
-
-  // System solution (including ghost elements).
-  TrilinosWrappers::MPI::Vector solution;
-
-  // System solution at previous time step.
-  TrilinosWrappers::MPI::Vector solution_old;
+  // Whether the problem runs in the time convergence study.
+  bool time_convergence_mode = false;
 };
 
-#endif
\ No newline at end of file
+#endif
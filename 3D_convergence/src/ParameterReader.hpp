@@ -12,9 +12,15 @@ struct SimulationParameters {
   double alpha; // Diffusion coefficient
   double dext;  // Diffusion coefficient for external term
 
-  double T;       // Final time
-  double deltat;  // Time step size
-  unsigned int r; // Polynomial degree
+  double T;                // Final time
+  double deltat;           // Time step size
+  double theta;            // Theta of the theta method
+  std::string time_scheme; // Theta or BDF2
+  unsigned int r;          // Polynomial degree
+
+  std::string study;              // Space or Time convergence study
+  std::string time_study_mesh;    // Mesh of the time convergence study
+  unsigned int time_study_levels; // Time steps of the time convergence study
 
   unsigned int max_newton_iterations; // Max iterations for Newton's method
   double newton_tolerance;            // Tolerance for Newton's method
@@ -85,7 +91,29 @@ void ParameterReader::declare_parameters() {
 
     prm.declare_entry(
         "Theta", "1.0", Patterns::Double(0.0, 1.0),
-        "Theta value for the time-stepping method (0=explicit, 1=implicit)");
+        "Theta value for the time-stepping method (0=explicit, 1=implicit, "
+        "0.5=Crank-Nicolson)");
+
+    prm.declare_entry("Time scheme", "Theta",
+                      Patterns::Selection("Theta|BDF2"),
+                      "Theta method with the given Theta (Theta), or the "
+                      "second-order backward differentiation formula (BDF2)");
+  }
+  prm.leave_subsection();
+
+  prm.enter_subsection("Convergence study");
+  {
+    prm.declare_entry("Study", "Space", Patterns::Selection("Space|Time"),
+                      "Convergence in the mesh size on the cube meshes "
+                      "(Space), or in the time step on a single mesh (Time)");
+
+    prm.declare_entry("Time study mesh", "../mesh/mesh-cube-8.msh",
+                      Patterns::Anything(),
+                      "Mesh file of the time convergence study");
+
+    prm.declare_entry("Time study levels", "4", Patterns::Integer(2),
+                      "Number of time steps of the time convergence study, "
+                      "each half the previous one, starting from deltat");
   }
   prm.leave_subsection();
 
@@ -126,6 +154,14 @@ ParameterReader::read_parameters(const std::string &parameter_file) {
   prm.enter_subsection("Time stepping parameters");
   params.T = prm.get_double("T");
   params.deltat = prm.get_double("deltat");
+  params.theta = prm.get_double("Theta");
+  params.time_scheme = prm.get("Time scheme");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Convergence study");
+  params.study = prm.get("Study");
+  params.time_study_mesh = prm.get("Time study mesh");
+  params.time_study_levels = prm.get_integer("Time study levels");
   prm.leave_subsection();
 
   prm.enter_subsection("Solver parameters");
@@ -4,7 +4,9 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 // Function to compute convergence order safely
 double compute_convergence(const double err_current, const double err_prev,
@@ -15,6 +17,96 @@ double compute_convergence(const double err_current, const double err_prev,
   return std::log(err_current / err_prev) / std::log(h_current / h_prev);
 }
 
+// Print an error with its convergence order with respect to the previous one.
+void print_error(const std::vector<double> &errors,
+                 const std::vector<double> &steps, const size_t i) {
+  std::cout << std::scientific << std::setprecision(2) << errors[i];
+
+  if (i > 0) {
+    double p =
+        compute_convergence(errors[i], errors[i - 1], steps[i], steps[i - 1]);
+    if (p < 0)
+      std::cout << " (n/a)";
+    else
+      std::cout << " (" << std::fixed << std::setprecision(2) << std::setw(4)
+                << p << ")";
+  } else {
+    std::cout << " (  - )";
+  }
+}
+
+// Convergence in the time step on a fixed mesh. The errors are measured
+// against a reference solution on the same mesh with a time step four times
+// smaller than the smallest one, so that the spatial error cancels out, and
+// the problem starts from the exact solution.
+int run_time_convergence(const SimulationParameters &params,
+                         const unsigned int mpi_rank) {
+  std::vector<double> deltat_vector;
+  for (unsigned int k = 0; k < params.time_study_levels; ++k)
+    deltat_vector.push_back(params.deltat / std::pow(2.0, k));
+
+  const auto make_problem = [&](const double deltat) {
+    auto problem = std::make_unique<FisherKolmogorov3D>(
+        params.time_study_mesh, params.dext, params.alpha, params.r, params.T,
+        deltat);
+
+    problem->set_solver_parameters(
+        params.max_newton_iterations, params.newton_tolerance,
+        params.max_cg_iterations, params.cg_tolerance_factor);
+    problem->set_time_scheme(params.time_scheme, params.theta);
+    problem->set_time_convergence_mode(true);
+    problem->setup();
+    problem->solve();
+
+    return problem;
+  };
+
+  const std::unique_ptr<FisherKolmogorov3D> reference =
+      make_problem(0.25 * deltat_vector.back());
+
+  std::vector<double> errors_L2;
+  std::vector<double> errors_H1;
+
+  for (const double deltat : deltat_vector) {
+    const std::unique_ptr<FisherKolmogorov3D> problem = make_problem(deltat);
+
+    errors_L2.push_back(
+        problem->compute_difference(*reference, VectorTools::L2_norm));
+    errors_H1.push_back(
+        problem->compute_difference(*reference, VectorTools::H1_norm));
+  }
+
+  // Rank 0 handles output
+  if (mpi_rank == 0) {
+    std::cout << "===============================================" << std::endl;
+    std::cout << "Time scheme = " << params.time_scheme;
+    if (params.time_scheme == "Theta")
+      std::cout << " (theta = " << params.theta << ")";
+    std::cout << std::endl;
+
+    std::ofstream convergence_file("time_convergence.csv");
+    if (!convergence_file) {
+      std::cerr << "Error: could not open time_convergence.csv for writing."
+                << std::endl;
+      return 1;
+    }
+    convergence_file << "deltat,eL2,eH1" << std::endl;
+
+    for (size_t i = 0; i < deltat_vector.size(); ++i) {
+      convergence_file << deltat_vector[i] << "," << errors_L2[i] << ","
+                       << errors_H1[i] << std::endl;
+
+      std::cout << std::scientific << "deltat = " << std::setw(4)
+                << std::setprecision(2) << deltat_vector[i] << " | eL2 = ";
+      print_error(errors_L2, deltat_vector, i);
+      std::cout << " | eH1 = ";
+      print_error(errors_H1, deltat_vector, i);
+      std::cout << "\n";
+    }
+  }
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   Utilities::MPI::MPI_InitFinalize mpi_init(argc, argv);
   const unsigned int mpi_rank =
@@ -44,6 +136,9 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  if (params.study == "Time")
+    return run_time_convergence(params, mpi_rank);
+
   std::vector<double> errors_L2;
   std::vector<double> errors_H1;
 
@@ -62,6 +157,7 @@ int main(int argc, char *argv[]) {
     problem.set_solver_parameters(
         params.max_newton_iterations, params.newton_tolerance,
         params.max_cg_iterations, params.cg_tolerance_factor);
+    problem.set_time_scheme(params.time_scheme, params.theta);
     problem.setup();
     problem.solve();
 
@@ -86,33 +182,10 @@ int main(int argc, char *argv[]) {
                        << errors_H1[i] << std::endl;
 
       std::cout << std::scientific << "h = " << std::setw(4)
-                << std::setprecision(2) << h_vector[i]
-                << " | eL2 = " << errors_L2[i];
-
-      if (i > 0) {
-        double p = compute_convergence(errors_L2[i], errors_L2[i - 1],
-                                       h_vector[i], h_vector[i - 1]);
-        if (p < 0)
-          std::cout << " (n/a)";
-        else
-          std::cout << " (" << std::fixed << std::setprecision(2)
-                    << std::setw(4) << p << ")";
-      } else {
-        std::cout << " (  - )";
-      }
-
-      std::cout << " | eH1 = " << errors_H1[i];
-      if (i > 0) {
-        double p = compute_convergence(errors_H1[i], errors_H1[i - 1],
-                                       h_vector[i], h_vector[i - 1]);
-        if (p < 0)
-          std::cout << " (n/a)";
-        else
-          std::cout << " (" << std::fixed << std::setprecision(2)
-                    << std::setw(4) << p << ")";
-      } else {
-        std::cout << " (  - )";
-      }
+                << std::setprecision(2) << h_vector[i] << " | eL2 = ";
+      print_error(errors_L2, h_vector, i);
+      std::cout << " | eH1 = ";
+      print_error(errors_H1, h_vector, i);
       std::cout << "\n";
     }
   }
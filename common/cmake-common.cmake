@@ -31,3 +31,6 @@ deal_ii_initialize_cached_variables()
 
 # Add useful compiler flags.
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wfloat-conversion -Wmissing-braces -Wnon-virtual-dtor")
+
+# Headers shared by the solvers.
+include_directories(${CMAKE_CURRENT_LIST_DIR}/src)
@@ -0,0 +1,172 @@
+#ifndef CELL_KERNEL_HPP
+#define CELL_KERNEL_HPP
+
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/tensor.h>
+
+#include <deal.II/fe/fe_values.h>
+
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
+
+using namespace dealii;
+
+// Cell kernel of a Newton iteration of the time step
+//   (a0 u + a1 un + a2 unn) - div(D grad u_theta)
+//     - alpha u_theta (1 - u_theta) = f_theta,
+// shared by the 1D, 3D and 3D convergence solvers. u_theta is theta u +
+// (1 - theta) un, the time coefficients are already divided by deltat, and
+// the residual is stored with changed sign.
+
+// Coefficients of the time step, and the terms that are assembled.
+struct CellKernelCoefficients {
+  double a0 = 1.0;
+  double a1 = -1.0;
+  double a2 = 0.0;
+  double theta = 1.0;
+  double alpha = 0.0;
+
+  // Whether the cell matrix is assembled at all, and whether it includes
+  // a0 M + theta K (which the split assembly adds separately) and the
+  // reaction terms of the matrix and of the residual (which the lumped
+  // reaction evaluates at the nodes instead).
+  bool matrix = true;
+  bool mass_and_stiffness = true;
+  bool reaction = true;
+};
+
+// Values at the quadrature points of the cell. The gradient of un is only
+// read if theta < 1, unn only if a2 != 0, and f is the forcing term
+// theta f(t_n+1) + (1 - theta) f(t_n), or nullptr if there is none.
+template <int dim> struct CellKernelData {
+  const double *u = nullptr;
+  const Tensor<1, dim> *u_gradient = nullptr;
+  const double *u_old = nullptr;
+  const Tensor<1, dim> *u_old_gradient = nullptr;
+  const double *u_older = nullptr;
+  const SymmetricTensor<2, dim> *d = nullptr;
+  const double *f = nullptr;
+};
+
+// Kernel with the number of DoFs per cell fixed at compile time (or taken
+// from fe_values if 0), so that the loops over the pairs of shape functions,
+// which dominate the cost, can be unrolled. The number of quadrature points
+// is that of fe_values. The matrix is symmetric: only its lower triangle is
+// computed.
+template <int dim, unsigned int n_dofs = 0>
+void fisher_kolmogorov_cell_kernel(const FEValues<dim> &fe_values,
+                                   const CellKernelData<dim> &data,
+                                   const CellKernelCoefficients &c,
+                                   FullMatrix<double> &cell_matrix,
+                                   Vector<double> &cell_residual) {
+  const unsigned int dofs_per_cell =
+      n_dofs > 0 ? n_dofs : fe_values.dofs_per_cell;
+  const unsigned int n_q = fe_values.n_quadrature_points;
+
+  const bool explicit_part = c.theta < 1.0;
+  const bool bdf2 = c.a2 != 0.0;
+
+  if (c.matrix)
+    cell_matrix = 0.0;
+  cell_residual = 0.0;
+
+  for (unsigned int q = 0; q < n_q; ++q) {
+    const double JxW = fe_values.JxW(q);
+    const double u = data.u[q];
+    const SymmetricTensor<2, dim> &d = data.d[q];
+
+    // Time derivative, diffusion flux, reaction and forcing term at the
+    // quadrature node, with the explicit part of the theta method.
+    double value_term = c.a0 * u + c.a1 * data.u_old[q];
+    if (bdf2)
+      value_term += c.a2 * data.u_older[q];
+
+    Tensor<1, dim> gradient = c.theta * data.u_gradient[q];
+    if (explicit_part)
+      gradient += (1 - c.theta) * data.u_old_gradient[q];
+
+    if (c.reaction) {
+      double reaction = c.theta * u * (1 - u);
+      if (explicit_part)
+        reaction += (1 - c.theta) * data.u_old[q] * (1 - data.u_old[q]);
+      value_term -= c.alpha * reaction;
+    }
+
+    if (data.f != nullptr)
+      value_term -= data.f[q];
+
+    const Tensor<1, dim> flux = d * gradient;
+
+    // Weight of phi_i phi_j in the matrix.
+    double mass_weight = c.mass_and_stiffness ? c.a0 : 0.0;
+    if (c.reaction)
+      mass_weight -= c.theta * c.alpha * (1 - 2 * u);
+    const double stiffness_weight = c.mass_and_stiffness ? c.theta : 0.0;
+
+    for (unsigned int i = 0; i < dofs_per_cell; ++i) {
+      const double phi_i = fe_values.shape_value(i, q);
+      const Tensor<1, dim> &grad_phi_i = fe_values.shape_grad(i, q);
+
+      if (c.matrix) {
+        const Tensor<1, dim> d_grad_phi_i = d * grad_phi_i;
+
+        for (unsigned int j = 0; j <= i; ++j)
+          cell_matrix(i, j) +=
+              (mass_weight * phi_i * fe_values.shape_value(j, q) +
+               stiffness_weight * d_grad_phi_i * fe_values.shape_grad(j, q)) *
+              JxW;
+      }
+
+      cell_residual(i) -= (value_term * phi_i + flux * grad_phi_i) * JxW;
+    }
+  }
+
+  if (c.matrix)
+    for (unsigned int i = 0; i < dofs_per_cell; ++i)
+      for (unsigned int j = i + 1; j < dofs_per_cell; ++j)
+        cell_matrix(i, j) = cell_matrix(j, i);
+}
+
+// Number of DoFs per cell of the Lagrange element of the given degree, on
+// hypercubes (Q) or on simplices (P).
+constexpr unsigned int lagrange_dofs_per_cell(const unsigned int dim,
+                                              const unsigned int degree,
+                                              const bool simplex) {
+  unsigned int n = 1;
+  for (unsigned int d = 1; d <= dim; ++d)
+    n = simplex ? n * (degree + d) / d : n * (degree + 1);
+  return n;
+}
+
+// Run the kernel, with the number of DoFs fixed at compile time for the Q
+// and P elements of degree up to max_degree, derived from the degree of the
+// element of fe_values. Other elements run the generic kernel.
+template <int dim, unsigned int degree = 1, unsigned int max_degree = 3>
+void fisher_kolmogorov_cell(const FEValues<dim> &fe_values,
+                            const CellKernelData<dim> &data,
+                            const CellKernelCoefficients &c,
+                            FullMatrix<double> &cell_matrix,
+                            Vector<double> &cell_residual) {
+  if constexpr (degree <= max_degree) {
+    if (fe_values.get_fe().degree != degree)
+      return fisher_kolmogorov_cell<dim, degree + 1, max_degree>(
+          fe_values, data, c, cell_matrix, cell_residual);
+
+    constexpr unsigned int q_dofs = lagrange_dofs_per_cell(dim, degree, false);
+    constexpr unsigned int p_dofs = lagrange_dofs_per_cell(dim, degree, true);
+
+    if (fe_values.dofs_per_cell == q_dofs)
+      return fisher_kolmogorov_cell_kernel<dim, q_dofs>(fe_values, data, c,
+                                                        cell_matrix,
+                                                        cell_residual);
+    if (fe_values.dofs_per_cell == p_dofs)
+      return fisher_kolmogorov_cell_kernel<dim, p_dofs>(fe_values, data, c,
+                                                        cell_matrix,
+                                                        cell_residual);
+  }
+
+  fisher_kolmogorov_cell_kernel<dim>(fe_values, data, c, cell_matrix,
+                                     cell_residual);
+}
+
+#endif
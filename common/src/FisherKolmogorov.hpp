@@ -0,0 +1,749 @@
+#ifndef FISHER_KOLMOGOROV_HPP
+#define FISHER_KOLMOGOROV_HPP
+
+#include "CellKernel.hpp"
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/quadrature.h>
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/work_stream.h>
+
+#include <deal.II/distributed/fully_distributed_tria.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+
+#include <deal.II/fe/fe.h>
+#include <deal.II/fe/fe_values.h>
+
+#include <deal.II/grid/filtered_iterator.h>
+#include <deal.II/grid/tria.h>
+
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/trilinos_precondition.h>
+#include <deal.II/lac/trilinos_sparse_matrix.h>
+#include <deal.II/lac/trilinos_sparsity_pattern.h>
+#include <deal.II/lac/trilinos_vector.h>
+#include <deal.II/lac/vector.h>
+
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// Serial linear algebra: deal.II vectors and sparse matrices, on a serial
+// triangulation. It does not use MPI, so the serial solvers need not
+// initialize it.
+struct SerialLinearAlgebra {
+  template <int dim> using Triangulation = dealii::Triangulation<dim>;
+  using Vector = dealii::Vector<double>;
+  using SparseMatrix = dealii::SparseMatrix<double>;
+  using Preconditioner = PreconditionSSOR<SparseMatrix>;
+
+  // Sparsity pattern, kept alive for the matrix.
+  struct Sparsity {
+    SparsityPattern pattern;
+  };
+
+  template <int dim>
+  static std::unique_ptr<Triangulation<dim>> create_triangulation() {
+    return std::make_unique<Triangulation<dim>>();
+  }
+
+  static bool is_root() { return true; }
+
+  static void reinit_vector(Vector &v, const IndexSet &owned) {
+    v.reinit(owned.size());
+  }
+
+  static void reinit_vector(Vector &v, const IndexSet &owned,
+                            const IndexSet & /*relevant*/) {
+    v.reinit(owned.size());
+  }
+
+  template <int dim>
+  static void reinit_matrix(SparseMatrix &matrix, Sparsity &sparsity,
+                            const DoFHandler<dim> &dof_handler,
+                            const IndexSet & /*owned*/) {
+    DynamicSparsityPattern dsp(dof_handler.n_dofs());
+    DoFTools::make_sparsity_pattern(dof_handler, dsp);
+    sparsity.pattern.copy_from(dsp);
+    matrix.reinit(sparsity.pattern);
+  }
+
+  static void initialize_preconditioner(Preconditioner &preconditioner,
+                                        const SparseMatrix &matrix) {
+    preconditioner.initialize(matrix,
+                              Preconditioner::AdditionalData(1.0));
+  }
+};
+
+// Distributed linear algebra: Trilinos vectors and matrices, on a fully
+// distributed triangulation over MPI_COMM_WORLD.
+struct TrilinosLinearAlgebra {
+  template <int dim>
+  using Triangulation = parallel::fullydistributed::Triangulation<dim>;
+  using Vector = TrilinosWrappers::MPI::Vector;
+  using SparseMatrix = TrilinosWrappers::SparseMatrix;
+  using Preconditioner = TrilinosWrappers::PreconditionSSOR;
+
+  // Trilinos matrices copy their sparsity pattern.
+  struct Sparsity {};
+
+  template <int dim>
+  static std::unique_ptr<Triangulation<dim>> create_triangulation() {
+    return std::make_unique<Triangulation<dim>>(MPI_COMM_WORLD);
+  }
+
+  static bool is_root() {
+    return Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0;
+  }
+
+  static void reinit_vector(Vector &v, const IndexSet &owned) {
+    v.reinit(owned, MPI_COMM_WORLD);
+  }
+
+  static void reinit_vector(Vector &v, const IndexSet &owned,
+                            const IndexSet &relevant) {
+    v.reinit(owned, relevant, MPI_COMM_WORLD);
+  }
+
+  template <int dim>
+  static void reinit_matrix(SparseMatrix &matrix, Sparsity & /*sparsity*/,
+                            const DoFHandler<dim> &dof_handler,
+                            const IndexSet &owned) {
+    TrilinosWrappers::SparsityPattern sparsity(owned, MPI_COMM_WORLD);
+    DoFTools::make_sparsity_pattern(dof_handler, sparsity);
+    sparsity.compress();
+    matrix.reinit(sparsity);
+  }
+
+  static void initialize_preconditioner(Preconditioner &preconditioner,
+                                        const SparseMatrix &matrix) {
+    preconditioner.initialize(matrix, Preconditioner::AdditionalData(1.0));
+  }
+};
+
+// Fisher-Kolmogorov problem
+//   du/dt - div(D grad u) - alpha u (1 - u) = f
+// in dim dimensions, with homogeneous Neumann conditions, discretized in
+// time with the theta method or BDF2 and solved at each time step with
+// Newton's method and SSOR-preconditioned CG. The linear algebra (serial or
+// Trilinos) is a template argument; the derived classes create the mesh,
+// the finite element and the coefficients, and write the output. The time
+// loop, Newton's method and the linear solve call virtual hooks at each
+// step, which a derived class overrides to extend them (adaptive time
+// steps, Jacobian reuse, other linear solvers).
+template <int dim, typename LinearAlgebra> class FisherKolmogorov {
+public:
+  using VectorType = typename LinearAlgebra::Vector;
+  using MatrixType = typename LinearAlgebra::SparseMatrix;
+  using TriangulationType = typename LinearAlgebra::template Triangulation<dim>;
+
+  FisherKolmogorov(const unsigned int r_, const double T_,
+                   const double deltat_, const double alpha_)
+      : FisherKolmogorov(r_, T_, deltat_, alpha_,
+                         ConditionalOStream(std::cout,
+                                            LinearAlgebra::is_root())) {}
+
+  // Constructor with the output stream of the caller.
+  FisherKolmogorov(const unsigned int r_, const double T_,
+                   const double deltat_, const double alpha_,
+                   const ConditionalOStream &pcout_)
+      : pcout(pcout_), alpha(alpha_), T(T_), r(r_), deltat(deltat_) {}
+
+  virtual ~FisherKolmogorov() = default;
+
+  // Set the parameters for the Newton method and CG solver.
+  void set_solver_parameters(const unsigned int max_newton_iter,
+                             const double newton_tol,
+                             const unsigned int max_cg_iter,
+                             const double cg_tol_factor) {
+    max_newton_iterations = max_newton_iter;
+    newton_tolerance = newton_tol;
+    max_cg_iterations = max_cg_iter;
+    cg_tolerance_factor = cg_tol_factor;
+  }
+
+  // Set the time scheme: the theta method with the given theta (Theta) or
+  // BDF2, which ignores it.
+  void set_time_scheme(const std::string &scheme, const double theta_) {
+    time_scheme = scheme;
+    theta = time_scheme == "BDF2" ? 1.0 : theta_;
+  }
+
+  // Initialization.
+  virtual void setup();
+
+  // Solve the problem.
+  virtual void solve();
+
+protected:
+  // Create the empty triangulation that create_mesh() fills. By default,
+  // that of the linear algebra.
+  virtual std::unique_ptr<TriangulationType> create_triangulation() const {
+    return LinearAlgebra::template create_triangulation<dim>();
+  }
+
+  // Create the mesh.
+  virtual void create_mesh() = 0;
+
+  // Create the finite element space and the quadrature formula.
+  virtual void create_finite_element() = 0;
+
+  // Diffusion tensor, evaluated once per quadrature point in setup().
+  virtual SymmetricTensor<2, dim>
+  diffusion_tensor(const Point<dim> &p) const = 0;
+
+  // Whether there is a forcing term, and its value.
+  virtual bool has_forcing_term() const { return false; }
+
+  virtual double forcing_term(const Point<dim> & /*p*/,
+                              const double /*t*/) const {
+    return 0.0;
+  }
+
+  // Interpolate the initial condition into the locally owned solution.
+  virtual void initial_condition(VectorType &u_0) = 0;
+
+  // Output.
+  virtual void output(const unsigned int &time_step) = 0;
+
+  // Hooks of the time loop of solve().
+
+  // Set the initial solution, and return the time step the run starts
+  // from. By default, the initial condition is applied and written.
+  virtual unsigned int start_run();
+
+  // Whether the time loop is over.
+  virtual bool final_time_reached() const { return time >= T - 0.5 * deltat; }
+
+  // Prepare the given time step, before the time advances to it.
+  virtual void begin_time_step(const unsigned int /*time_step*/) {}
+
+  // Compute the coefficients of the time derivative of the given time step,
+  // before the current solution becomes the old one.
+  virtual void update_time_scheme(const unsigned int time_step);
+
+  // Compute the solution of the current time step, and return whether it
+  // converged. By default, with Newton's method.
+  virtual bool solve_time_step() { return solve_newton(); }
+
+  // Whether the current time step is accepted. A rejected step is repeated
+  // from the previous time, with the solution and the time step the derived
+  // class restored. By default every step is accepted.
+  virtual bool accept_time_step(const bool converged);
+
+  // Finish an accepted time step. By default, the solution is written.
+  virtual void end_time_step(const unsigned int time_step) {
+    output(time_step);
+  }
+
+  // Finish the run, after the given number of time steps.
+  virtual void end_run(const unsigned int /*n_time_steps*/) {}
+
+  // Hooks of Newton's method.
+
+  // Whether the current Jacobian is kept at the given Newton iteration,
+  // from the residual norms of the two previous ones. By default it is
+  // assembled at every iteration.
+  virtual bool reuse_jacobian(const unsigned int /*n_iter*/,
+                              const double /*residual_norm_old*/,
+                              const double /*residual_norm_older*/) {
+    return false;
+  }
+
+  // Relative tolerance of the linear solve of the given Newton iteration.
+  virtual double linear_tolerance(const unsigned int /*n_iter*/,
+                                  const double /*residual_norm*/,
+                                  const double /*residual_norm_old*/) const {
+    return cg_tolerance_factor;
+  }
+
+  // Update the ghosted solution after a Newton update.
+  virtual void update_newton_iterate() { solution = solution_owned; }
+
+  // Solve the tangent problem for delta_owned to the tolerance of the
+  // solver control, and return the number of iterations. By default, with
+  // CG and SSOR on the assembled Jacobian.
+  virtual unsigned int solve_tangent_problem(SolverControl &solver_control);
+
+  // Per-thread scratch data for the cell assembly.
+  struct AssemblyScratchData {
+    AssemblyScratchData(const FiniteElement<dim> &fe,
+                        const Quadrature<dim> &quadrature,
+                        const UpdateFlags update_flags)
+        : fe_values(fe, quadrature, update_flags),
+          solution_loc(quadrature.size()),
+          solution_gradient_loc(quadrature.size()),
+          solution_old_loc(quadrature.size()),
+          solution_old_gradient_loc(quadrature.size()),
+          solution_older_loc(quadrature.size()),
+          forcing_loc(quadrature.size()) {}
+
+    AssemblyScratchData(const AssemblyScratchData &scratch_data)
+        : AssemblyScratchData(scratch_data.fe_values.get_fe(),
+                              scratch_data.fe_values.get_quadrature(),
+                              scratch_data.fe_values.get_update_flags()) {}
+
+    FEValues<dim> fe_values;
+
+    std::vector<double> solution_loc;
+    std::vector<Tensor<1, dim>> solution_gradient_loc;
+    std::vector<double> solution_old_loc;
+    std::vector<Tensor<1, dim>> solution_old_gradient_loc;
+    std::vector<double> solution_older_loc;
+    std::vector<double> forcing_loc;
+  };
+
+  // Cell contributions copied into the global system.
+  struct AssemblyCopyData {
+    FullMatrix<double> cell_matrix;
+    Vector<double> cell_residual;
+    std::vector<types::global_dof_index> dof_indices;
+  };
+
+  // Assemble the tangent problem. If assemble_jacobian is false, only the
+  // residual is assembled and the current Jacobian is kept.
+  virtual void assemble_system(const bool assemble_jacobian = true);
+
+  // Assemble the contributions of a single cell.
+  void local_assemble_system(
+      const typename DoFHandler<dim>::active_cell_iterator &cell,
+      AssemblyScratchData &scratch, AssemblyCopyData &copy_data) const;
+
+  // Solve the linear system associated to the tangent problem.
+  void solve_linear_system();
+
+  // Solve the problem for one time step using Newton's method. Returns
+  // whether the Newton iterations converged.
+  bool solve_newton();
+
+  // Parallel output stream.
+  ConditionalOStream pcout;
+
+  // Reaction coefficient.
+  double alpha;
+
+  // Current time.
+  double time = 0.0;
+
+  // Final time.
+  const double T;
+
+  // Solver parameters.
+  unsigned int max_newton_iterations = 1000;
+  double newton_tolerance = 1e-6;
+  unsigned int max_cg_iterations = 1000;
+  double cg_tolerance_factor = 1e-6;
+
+  // Relative CG tolerance of the current Newton iteration.
+  double linear_tolerance_factor = 1e-6;
+
+  // Newton and CG iterations of the current time step, and since the
+  // beginning of the run.
+  unsigned int newton_iterations_step = 0;
+  unsigned int cg_iterations_step = 0;
+  unsigned int newton_iterations_total = 0;
+  unsigned int cg_iterations_total = 0;
+
+  // Polynomial degree.
+  const unsigned int r;
+
+  // Time step.
+  double deltat;
+
+  // Time scheme (Theta or BDF2).
+  std::string time_scheme = "Theta";
+
+  // Theta parameter of the theta method (1 with BDF2).
+  double theta = 1.0;
+
+  // Coefficients of the time derivative (a0 u + a1 un + a2 unn) / deltat.
+  // BDF2 starts with a backward Euler step.
+  std::array<double, 3> time_coefficients = {{1.0, -1.0, 0.0}};
+
+  // Mesh.
+  std::unique_ptr<TriangulationType> mesh;
+
+  // Finite element space.
+  std::unique_ptr<FiniteElement<dim>> fe;
+
+  // Quadrature formula.
+  std::unique_ptr<Quadrature<dim>> quadrature;
+
+  // DoF handler.
+  DoFHandler<dim> dof_handler;
+
+  // DoFs owned by current process.
+  IndexSet locally_owned_dofs;
+
+  // DoFs relevant to the current process (including ghost DoFs).
+  IndexSet locally_relevant_dofs;
+
+  // Diffusion tensor at the quadrature points, indexed by
+  // active_cell_index() * n_q + q.
+  std::vector<SymmetricTensor<2, dim>> diffusion_tensor_cache;
+
+  // Sparsity pattern of the Jacobian, if the matrix does not copy it.
+  typename LinearAlgebra::Sparsity sparsity;
+
+  // Jacobian matrix.
+  MatrixType jacobian_matrix;
+
+  // Residual vector.
+  VectorType residual_vector;
+
+  // Increment of the solution between Newton iterations.
+  VectorType delta_owned;
+
+  // System solution (without ghost elements).
+  VectorType solution_owned;
+
+  // System solution (including ghost elements).
+  VectorType solution;
+
+  // System solution at previous time step.
+  VectorType solution_old;
+
+  // System solution two time steps before (BDF2).
+  VectorType solution_older;
+};
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::setup() {
+  mesh = create_triangulation();
+  create_mesh();
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Initialize the finite element space.
+  {
+    pcout << "Initializing the finite element space" << std::endl;
+
+    create_finite_element();
+
+    pcout << "  Degree                     = " << fe->degree << std::endl;
+    pcout << "  DoFs per cell              = " << fe->dofs_per_cell
+          << std::endl;
+    pcout << "  Quadrature points per cell = " << quadrature->size()
+          << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // Initialize the DoF handler.
+  {
+    pcout << "Initializing the DoF handler" << std::endl;
+
+    dof_handler.reinit(*mesh);
+    dof_handler.distribute_dofs(*fe);
+
+    locally_owned_dofs = dof_handler.locally_owned_dofs();
+    DoFTools::extract_locally_relevant_dofs(dof_handler, locally_relevant_dofs);
+
+    pcout << "  Number of DoFs = " << dof_handler.n_dofs() << std::endl;
+  }
+
+  pcout << "-----------------------------------------------" << std::endl;
+
+  // The diffusion tensor does not depend on time: evaluate it once.
+  {
+    const unsigned int n_q = quadrature->size();
+    FEValues<dim> fe_values(*fe, *quadrature, update_quadrature_points);
+
+    diffusion_tensor_cache.assign(mesh->n_active_cells() * n_q,
+                                  SymmetricTensor<2, dim>());
+    for (const auto &cell : dof_handler.active_cell_iterators()) {
+      if (!cell->is_locally_owned())
+        continue;
+
+      fe_values.reinit(cell);
+      const unsigned int offset = cell->active_cell_index() * n_q;
+      for (unsigned int q = 0; q < n_q; ++q)
+        diffusion_tensor_cache[offset + q] =
+            diffusion_tensor(fe_values.quadrature_point(q));
+    }
+  }
+
+  // Initialize the linear system.
+  {
+    pcout << "Initializing the linear system" << std::endl;
+
+    pcout << "  Initializing the sparsity pattern" << std::endl;
+    pcout << "  Initializing the matrices" << std::endl;
+    LinearAlgebra::reinit_matrix(jacobian_matrix, sparsity, dof_handler,
+                                 locally_owned_dofs);
+
+    pcout << "  Initializing the system right-hand side" << std::endl;
+    LinearAlgebra::reinit_vector(residual_vector, locally_owned_dofs);
+    pcout << "  Initializing the solution vector" << std::endl;
+    LinearAlgebra::reinit_vector(solution_owned, locally_owned_dofs);
+    LinearAlgebra::reinit_vector(delta_owned, locally_owned_dofs);
+
+    LinearAlgebra::reinit_vector(solution, locally_owned_dofs,
+                                 locally_relevant_dofs);
+    solution_old = solution;
+    solution_older = solution;
+  }
+}
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::assemble_system(
+    const bool assemble_jacobian) {
+  const unsigned int dofs_per_cell = fe->dofs_per_cell;
+
+  if (assemble_jacobian)
+    jacobian_matrix = 0.0;
+  residual_vector = 0.0;
+
+  UpdateFlags update_flags = update_values | update_gradients |
+                             update_JxW_values;
+  if (has_forcing_term())
+    update_flags |= update_quadrature_points;
+
+  // Cells are assembled concurrently by the worker threads, while the copier
+  // adds their contributions to the global system one at a time.
+  using CellIterator = typename DoFHandler<dim>::active_cell_iterator;
+  using CellFilter = FilteredIterator<CellIterator>;
+
+  AssemblyScratchData scratch_data(*fe, *quadrature, update_flags);
+
+  AssemblyCopyData copy_data;
+  copy_data.cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+  copy_data.cell_residual.reinit(dofs_per_cell);
+  copy_data.dof_indices.resize(dofs_per_cell);
+
+  WorkStream::run(
+      CellFilter(IteratorFilters::LocallyOwnedCell(),
+                 dof_handler.begin_active()),
+      CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+      [this](const CellIterator &cell, AssemblyScratchData &scratch,
+             AssemblyCopyData &copy) {
+        local_assemble_system(cell, scratch, copy);
+      },
+      [this, assemble_jacobian](const AssemblyCopyData &copy) {
+        if (assemble_jacobian)
+          jacobian_matrix.add(copy.dof_indices, copy.cell_matrix);
+        residual_vector.add(copy.dof_indices, copy.cell_residual);
+      },
+      scratch_data, copy_data);
+
+  if (assemble_jacobian)
+    jacobian_matrix.compress(VectorOperation::add);
+  residual_vector.compress(VectorOperation::add);
+}
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::local_assemble_system(
+    const typename DoFHandler<dim>::active_cell_iterator &cell,
+    AssemblyScratchData &scratch, AssemblyCopyData &copy_data) const {
+  FEValues<dim> &fe_values = scratch.fe_values;
+  const unsigned int n_q = quadrature->size();
+
+  fe_values.reinit(cell);
+
+  fe_values.get_function_values(solution, scratch.solution_loc);
+  fe_values.get_function_gradients(solution, scratch.solution_gradient_loc);
+  fe_values.get_function_values(solution_old, scratch.solution_old_loc);
+  if (theta < 1.0)
+    fe_values.get_function_gradients(solution_old,
+                                     scratch.solution_old_gradient_loc);
+  if (time_coefficients[2] != 0.0)
+    fe_values.get_function_values(solution_older, scratch.solution_older_loc);
+
+  // Forcing term weighted by theta.
+  if (has_forcing_term())
+    for (unsigned int q = 0; q < n_q; ++q) {
+      const Point<dim> &p = fe_values.quadrature_point(q);
+      scratch.forcing_loc[q] = theta * forcing_term(p, time);
+      if (theta < 1.0)
+        scratch.forcing_loc[q] += (1 - theta) * forcing_term(p, time - deltat);
+    }
+
+  CellKernelData<dim> data;
+  data.u = scratch.solution_loc.data();
+  data.u_gradient = scratch.solution_gradient_loc.data();
+  data.u_old = scratch.solution_old_loc.data();
+  data.u_old_gradient = scratch.solution_old_gradient_loc.data();
+  data.u_older = scratch.solution_older_loc.data();
+  data.d = &diffusion_tensor_cache[cell->active_cell_index() * n_q];
+  data.f = has_forcing_term() ? scratch.forcing_loc.data() : nullptr;
+
+  CellKernelCoefficients coefficients;
+  coefficients.a0 = time_coefficients[0] / deltat;
+  coefficients.a1 = time_coefficients[1] / deltat;
+  coefficients.a2 = time_coefficients[2] / deltat;
+  coefficients.theta = theta;
+  coefficients.alpha = alpha;
+
+  fisher_kolmogorov_cell(fe_values, data, coefficients, copy_data.cell_matrix,
+                         copy_data.cell_residual);
+
+  cell->get_dof_indices(copy_data.dof_indices);
+}
+
+template <int dim, typename LinearAlgebra>
+unsigned int FisherKolmogorov<dim, LinearAlgebra>::solve_tangent_problem(
+    SolverControl &solver_control) {
+  SolverCG<VectorType> solver(solver_control);
+  typename LinearAlgebra::Preconditioner preconditioner;
+  LinearAlgebra::initialize_preconditioner(preconditioner, jacobian_matrix);
+
+  solver.solve(jacobian_matrix, delta_owned, residual_vector, preconditioner);
+  return solver_control.last_step();
+}
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::solve_linear_system() {
+  SolverControl solver_control(max_cg_iterations,
+                               linear_tolerance_factor *
+                                   residual_vector.l2_norm());
+
+  const unsigned int n_iterations = solve_tangent_problem(solver_control);
+  pcout << "  " << n_iterations << " CG iterations" << std::endl;
+
+  cg_iterations_step += n_iterations;
+  cg_iterations_total += n_iterations;
+}
+
+template <int dim, typename LinearAlgebra>
+bool FisherKolmogorov<dim, LinearAlgebra>::solve_newton() {
+  unsigned int n_iter = 0;
+  double residual_norm = newton_tolerance + 1;
+
+  // Residual norms of the two previous iterations.
+  double residual_norm_old = 0.0;
+  double residual_norm_older = 0.0;
+
+  newton_iterations_step = 0;
+  cg_iterations_step = 0;
+
+  linear_tolerance_factor = cg_tolerance_factor;
+
+  while (n_iter < max_newton_iterations && residual_norm > newton_tolerance) {
+    const bool reuse =
+        reuse_jacobian(n_iter, residual_norm_old, residual_norm_older);
+    assemble_system(!reuse);
+    residual_norm = residual_vector.l2_norm();
+
+    pcout << "  Newton iteration " << n_iter << "/" << max_newton_iterations
+          << " - ||r|| = " << std::scientific << std::setprecision(6)
+          << residual_norm << (reuse ? " (Jacobian reused)" : "")
+          << std::flush;
+
+    // We actually solve the system only if the residual is larger than the
+    // tolerance.
+    if (residual_norm > newton_tolerance) {
+      linear_tolerance_factor =
+          linear_tolerance(n_iter, residual_norm, residual_norm_old);
+      solve_linear_system();
+
+      solution_owned += delta_owned;
+      update_newton_iterate();
+    } else {
+      pcout << " < tolerance" << std::endl;
+    }
+
+    residual_norm_older = residual_norm_old;
+    residual_norm_old = residual_norm;
+
+    ++n_iter;
+  }
+
+  newton_iterations_step = n_iter;
+  newton_iterations_total += n_iter;
+
+  return residual_norm <= newton_tolerance;
+}
+
+template <int dim, typename LinearAlgebra>
+unsigned int FisherKolmogorov<dim, LinearAlgebra>::start_run() {
+  // Apply the initial condition.
+  pcout << "Applying the initial condition" << std::endl;
+
+  initial_condition(solution_owned);
+  solution = solution_owned;
+
+  // Output the initial solution.
+  output(0);
+  pcout << "-----------------------------------------------" << std::endl;
+
+  return 0;
+}
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::update_time_scheme(
+    const unsigned int time_step) {
+  // After the first (backward Euler) step, BDF2 has both old solutions.
+  if (time_scheme == "BDF2" && time_step > 1) {
+    solution_older = solution_old;
+    time_coefficients = {{1.5, -2.0, 0.5}};
+  }
+}
+
+template <int dim, typename LinearAlgebra>
+bool FisherKolmogorov<dim, LinearAlgebra>::accept_time_step(
+    const bool converged) {
+  if (!converged)
+    pcout << "  Warning: Newton did not converge within "
+          << max_newton_iterations << " iterations" << std::endl;
+
+  return true;
+}
+
+template <int dim, typename LinearAlgebra>
+void FisherKolmogorov<dim, LinearAlgebra>::solve() {
+  pcout << "===============================================" << std::endl;
+
+  time = 0.0;
+  newton_iterations_total = 0;
+  cg_iterations_total = 0;
+
+  unsigned int time_step = start_run();
+  const unsigned int first_time_step = time_step;
+
+  while (!final_time_reached()) {
+    begin_time_step(time_step + 1);
+
+    const double step = deltat;
+    time += step;
+    ++time_step;
+
+    // Store the old solutions, so that they are available for assembly.
+    update_time_scheme(time_step);
+    solution_old = solution;
+
+    pcout << "n = " << std::setw(3) << time_step << ", t = " << std::setw(5)
+          << std::fixed << time << std::endl;
+
+    // At every time step, we invoke Newton's method (or the solver of the
+    // derived class) to solve the non-linear problem.
+    const bool converged = solve_time_step();
+
+    // A rejected step is repeated from the previous time.
+    if (!accept_time_step(converged)) {
+      time -= step;
+      --time_step;
+      continue;
+    }
+
+    end_time_step(time_step);
+
+    pcout << std::endl;
+  }
+
+  end_run(time_step - first_time_step);
+}
+
+#endif